@@ -4,5 +4,6 @@ namespace PathConfig {
 
     inline static constexpr std::string_view res_dir = "@RES_FOLDER@";
     inline static constexpr std::string_view shader_dir = "@SHADER_FOLDER@";
+    inline static constexpr std::string_view cache_dir = "@CACHE_FOLDER@";
 
 }
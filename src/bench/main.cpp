@@ -0,0 +1,865 @@
+#include "scene/loader.hpp"
+#include "scene/bvh.hpp"
+#include "scene/traversal.hpp"
+#include "scene/instance_bvh.hpp"
+#include "scene/wavefront.hpp"
+#include "scene/obj_parser.hpp"
+#include "platform/cache_counter.hpp"
+#include "platform/mapped_file.hpp"
+
+#include "report.hpp"
+
+#include <pathconfig.inl>
+
+namespace {
+
+    constexpr u32 s_repeats = 3;
+
+    constexpr u32 s_image_width = 1280;
+    constexpr u32 s_image_height = 720;
+    // pixel blocks emitted together so consecutive rays form compact packets of up to 16
+    constexpr u32 s_block_size = 4;
+
+    struct BuildResult
+    {
+        Bvh bvh;
+        f64 best_ms;
+    };
+
+    auto timed_build(std::span<const BvhTriangle> triangles, const BvhBuildOptions& options) -> BuildResult
+    {
+        BuildResult result { .bvh = {}, .best_ms = std::numeric_limits<f64>::max() };
+
+        for (u32 i = 0; i < s_repeats; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            result.bvh = Bvh::build(triangles, options);
+            std::chrono::duration<f64, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+            result.best_ms = std::min(result.best_ms, elapsed.count());
+        }
+
+        return result;
+    }
+
+    // best of s_repeats parses of the mapped source on every hardware thread, the import step the mesh cache skips
+    auto parse_throughput(const std::string& asset) -> f64
+    {
+        MappedFile file(std::filesystem::path(PathConfig::res_dir) / asset);
+        if (!file.valid()) return 0.0;
+
+        f64 best_ms = std::numeric_limits<f64>::max();
+        for (u32 i = 0; i < s_repeats; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            ObjData data = ObjParser::parse(file.bytes());
+            best_ms = std::min(best_ms, std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        return static_cast<f64>(file.size()) / (1024.0 * 1024.0) / (best_ms / 1000.0);
+    }
+
+    auto leaf_count(const Bvh& bvh) -> usize
+    {
+        return std::ranges::count_if(bvh.nodes(), [](const BvhNode& node) { return node.leaf(); });
+    }
+
+    auto bench_bvh(const std::string& asset) -> void
+    {
+        Model model = Loader::load_obj(asset);
+        auto triangles = Bvh::triangles_of(*model.mesh);
+
+        u32 threads = std::max(1u, std::thread::hardware_concurrency());
+
+        std::println("bvh build: {} ({} triangles)", asset, triangles.size());
+
+        auto serial = timed_build(triangles, BvhBuildOptions { .thread_count = 1 });
+        auto parallel = timed_build(triangles, BvhBuildOptions { .thread_count = threads });
+
+        std::println(" - 1 thread: {:.2f} ms", serial.best_ms);
+        std::println(" - {} threads: {:.2f} ms ({:.2f}x)", threads, parallel.best_ms, serial.best_ms / parallel.best_ms);
+        std::println(" - {} nodes, {} leaves, depth {}, sah cost {:.2f}",
+            parallel.bvh.nodes().size(), leaf_count(parallel.bvh), parallel.bvh.depth(), parallel.bvh.sah_cost()
+        );
+
+        // bin resolution trades build time against tree quality
+        for (u32 bins : { 8u, 16u, 32u }) {
+            auto result = timed_build(triangles, BvhBuildOptions { .bin_count = bins, .thread_count = threads });
+            std::println(" - {:>2} bins: {:.2f} ms, sah cost {:.2f}", bins, result.best_ms, result.bvh.sah_cost());
+        }
+    }
+
+
+    // pinhole at the scene center looking down +x, the long axis of sponza
+    auto primary_rays(const Bounds& bounds) -> std::vector<Ray>
+    {
+        std::vector<Ray> rays;
+        rays.reserve(static_cast<usize>(s_image_width) * s_image_height);
+
+        glm::vec3 origin = bounds.center();
+        f32 aspect = static_cast<f32>(s_image_height) / static_cast<f32>(s_image_width);
+
+        for (u32 by = 0; by < s_image_height; by += s_block_size) {
+            for (u32 bx = 0; bx < s_image_width; bx += s_block_size) {
+                for (u32 y = by; y < std::min(by + s_block_size, s_image_height); ++y) {
+                    for (u32 x = bx; x < std::min(bx + s_block_size, s_image_width); ++x) {
+                        f32 u = (static_cast<f32>(x) + 0.5f) / static_cast<f32>(s_image_width) * 2.0f - 1.0f;
+                        f32 v = (static_cast<f32>(y) + 0.5f) / static_cast<f32>(s_image_height) * 2.0f - 1.0f;
+
+                        rays.push_back(Ray {
+                            .origin = origin,
+                            .direction = glm::normalize(glm::vec3(1.0f, v * aspect, u)),
+                            .tmin = 0.0f,
+                            .tmax = std::numeric_limits<f32>::max()
+                        });
+                    }
+                }
+            }
+        }
+
+        return rays;
+    }
+
+    // uniform directions from the primary hit points, the incoherent case of diffuse bounces
+    auto secondary_rays(std::span<const Ray> primary, std::span<const Hit> hits, f32 epsilon) -> std::vector<Ray>
+    {
+        std::vector<Ray> rays;
+        rays.reserve(primary.size());
+
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<f32> uniform(0.0f, 1.0f);
+
+        for (usize i = 0; i < primary.size(); ++i) {
+            if (!hits[i].valid()) continue;
+
+            f32 z = uniform(rng) * 2.0f - 1.0f;
+            f32 phi = uniform(rng) * 2.0f * std::numbers::pi_v<f32>;
+            f32 r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+
+            rays.push_back(Ray {
+                .origin = primary[i].origin + primary[i].direction * hits[i].t,
+                .direction = glm::vec3(r * std::cos(phi), r * std::sin(phi), z),
+                .tmin = epsilon,
+                .tmax = std::numeric_limits<f32>::max()
+            });
+        }
+
+        return rays;
+    }
+
+    struct TraceResult
+    {
+        std::vector<Hit> hits;
+        f64 mrays;
+    };
+
+    template <typename Fn>
+    auto timed_trace(usize ray_count, Fn&& trace) -> TraceResult
+    {
+        TraceResult result { .hits = {}, .mrays = 0.0 };
+
+        f64 best_ms = std::numeric_limits<f64>::max();
+        for (u32 i = 0; i < s_repeats; ++i) {
+            result.hits.assign(ray_count, Hit {});
+
+            auto start = std::chrono::steady_clock::now();
+            trace(result.hits);
+            std::chrono::duration<f64, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+            best_ms = std::min(best_ms, elapsed.count());
+        }
+
+        result.mrays = static_cast<f64>(ray_count) / (best_ms * 1000.0);
+        return result;
+    }
+
+    auto mismatches(std::span<const Hit> hits, std::span<const Hit> reference) -> usize
+    {
+        usize count = 0;
+        for (usize i = 0; i < hits.size(); ++i) {
+            if (hits[i].primitive != reference[i].primitive) count++;
+        }
+        return count;
+    }
+
+    auto mebibytes(usize bytes) -> f64
+    {
+        return static_cast<f64>(bytes) / (1024.0 * 1024.0);
+    }
+
+    template <u32 Width>
+    auto bench_compressed_width(const CompressedBvh<Width>& compressed, std::span<const Ray> rays, std::span<const Hit> reference) -> void
+    {
+        auto result = timed_trace(rays.size(), [&](std::span<Hit> hits) {
+            Traversal::intersect_stream(compressed, rays, hits);
+        });
+
+        std::println(" - bvh{} quantized: {:.2f} MiB in {} nodes of {} bytes, secondary {:>7.2f} Mrays/s",
+            Width, mebibytes(compressed.nodes().size_bytes()), compressed.nodes().size(), sizeof(CompressedBvhNode<Width>), result.mrays
+        );
+
+        usize wrong = mismatches(result.hits, reference);
+        if (wrong > 0) {
+            std::println(std::cerr, "   {} hits differ from the scalar reference", wrong);
+        }
+    }
+
+    // node memory against throughput for the full precision and the quantized layouts
+    auto bench_compressed(const Bvh& bvh, const WideBvh& wide, std::span<const Ray> rays, std::span<const Hit> reference) -> void
+    {
+        std::println("compressed nodes ({}):", Traversal::name(Traversal::detect()));
+        std::println(" - binary: {:.2f} MiB in {} nodes of {} bytes", mebibytes(bvh.nodes().size_bytes()), bvh.nodes().size(), sizeof(BvhNode));
+        std::println(" - bvh8 fp32: {:.2f} MiB in {} nodes of {} bytes", mebibytes(wide.nodes().size_bytes()), wide.nodes().size(), sizeof(WideBvhNode));
+
+        bench_compressed_width(CompressedBvh<4>::build(bvh), rays, reference);
+        bench_compressed_width(CompressedBvh<8>::build(bvh), rays, reference);
+    }
+
+    struct SpatialRow
+    {
+        std::string name;
+        Bvh bvh;
+        f64 build_ms;
+    };
+
+    // spatial splits against the plain binned build, traced with the detected level
+    auto bench_spatial(std::span<const BvhTriangle> triangles, std::span<const Ray> primary, std::span<const Ray> secondary) -> void
+    {
+        std::vector<SpatialRow> rows;
+
+        auto plain = timed_build(triangles, BvhBuildOptions {});
+        rows.push_back(SpatialRow { .name = "binned", .bvh = std::move(plain.bvh), .build_ms = plain.best_ms });
+
+        for (f32 budget : { 0.1f, 0.3f, 1.0f }) {
+            auto spatial = timed_build(triangles, BvhBuildOptions { .spatial_splits = true, .duplication_budget = budget });
+            rows.push_back(SpatialRow { .name = std::format("sbvh {:.0f}%", budget * 100.0f), .bvh = std::move(spatial.bvh), .build_ms = spatial.best_ms });
+        }
+
+        std::println("spatial splits ({}):", Traversal::name(Traversal::detect()));
+
+        for (const auto& row : rows) {
+            WideBvh wide = WideBvh::build(row.bvh);
+
+            auto packets = timed_trace(primary.size(), [&](std::span<Hit> hits) {
+                Traversal::intersect_packets(row.bvh, primary, hits);
+            });
+            auto stream = timed_trace(secondary.size(), [&](std::span<Hit> hits) {
+                Traversal::intersect_stream(wide, secondary, hits);
+            });
+
+            f64 duplication = static_cast<f64>(row.bvh.primitives().size()) / static_cast<f64>(triangles.size()) - 1.0;
+
+            std::println(" - {:<9} {:>8.2f} ms, {} nodes, {} references (+{:.1f}%), sah cost {:.2f}, primary {:.2f} Mrays/s, secondary {:.2f} Mrays/s",
+                row.name, row.build_ms, row.bvh.nodes().size(), row.bvh.primitives().size(), duplication * 100.0,
+                row.bvh.sah_cost(), packets.mrays, stream.mrays
+            );
+        }
+    }
+
+    constexpr u32 s_instance_grid = 8;
+
+    // a grid of instances of one mesh, shared BLAS against one BVH over every transformed triangle
+    auto bench_instances(const std::string& asset) -> void
+    {
+        Model model = Loader::load_obj(asset);
+        auto triangles = Bvh::triangles_of(*model.mesh);
+
+        auto blas = std::make_shared<const Bvh>(Bvh::build(triangles));
+
+        Bounds local = blas->bounds();
+        f32 spacing = glm::length(local.extent()) * 2.5f;
+
+        std::vector<BvhInstance> instances;
+        std::vector<BvhTriangle> flattened;
+        flattened.reserve(triangles.size() * s_instance_grid * s_instance_grid);
+
+        for (u32 z = 0; z < s_instance_grid; ++z) {
+            for (u32 x = 0; x < s_instance_grid; ++x) {
+                f32 angle = static_cast<f32>(x + z * s_instance_grid) * 0.7f;
+
+                glm::mat4 matrix(1.0f);
+                matrix[0] = glm::vec4(std::cos(angle), 0.0f, -std::sin(angle), 0.0f);
+                matrix[2] = glm::vec4(std::sin(angle), 0.0f, std::cos(angle), 0.0f);
+                matrix[3] = glm::vec4(static_cast<f32>(x) * spacing, 0.0f, static_cast<f32>(z) * spacing, 1.0f);
+
+                Transform3x4 transform = Transform3x4::from(matrix);
+                instances.push_back(BvhInstance { .blas = blas, .transform = transform, .custom_index = static_cast<u32>(instances.size()) });
+
+                for (const auto& triangle : triangles) {
+                    flattened.push_back(BvhTriangle { transform.point(triangle.v0), transform.point(triangle.v1), transform.point(triangle.v2) });
+                }
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        InstanceBvh instanced = InstanceBvh::build(instances);
+        std::chrono::duration<f64, std::milli> top_time = std::chrono::steady_clock::now() - start;
+
+        auto flat = timed_build(flattened, BvhBuildOptions {});
+
+        // move one instance, only the top level is rebuilt
+        instanced.set_transform(0, Transform3x4::from(glm::mat4(1.0f)));
+        start = std::chrono::steady_clock::now();
+        instanced.rebuild();
+        std::chrono::duration<f64, std::milli> rebuild_time = std::chrono::steady_clock::now() - start;
+
+        // rays from above the grid looking down into it
+        Bounds world = instanced.bounds();
+
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<f32> uniform(0.0f, 1.0f);
+
+        std::vector<Ray> rays(static_cast<usize>(s_image_width) * s_image_height / 4);
+        for (auto& ray : rays) {
+            glm::vec3 target = world.min + (world.max - world.min) * glm::vec3(uniform(rng), uniform(rng), uniform(rng));
+            glm::vec3 origin = glm::vec3(world.center().x, world.max.y + spacing, world.center().z);
+            ray = Ray { .origin = origin, .direction = glm::normalize(target - origin), .tmin = 0.0f, .tmax = std::numeric_limits<f32>::max() };
+        }
+
+        auto instanced_trace = timed_trace(rays.size(), [&](std::span<Hit> hits) {
+            for (usize i = 0; i < rays.size(); ++i) hits[i] = instanced.intersect(rays[i]);
+        });
+        auto flat_trace = timed_trace(rays.size(), [&](std::span<Hit> hits) {
+            for (usize i = 0; i < rays.size(); ++i) hits[i] = flat.bvh.intersect(rays[i]);
+        });
+
+        std::println("instancing: {} x {} ({} triangles each)", asset, instances.size(), triangles.size());
+        std::println(" - two level: {:.2f} MiB, top level build {:.3f} ms, rebuild after a move {:.3f} ms, {:.2f} Mrays/s",
+            mebibytes(instanced.memory_size()), top_time.count(), rebuild_time.count(), instanced_trace.mrays
+        );
+        std::println(" - flattened: {:.2f} MiB, build {:.2f} ms, {:.2f} Mrays/s",
+            mebibytes(flat.bvh.memory_size()), flat.best_ms, flat_trace.mrays
+        );
+    }
+
+    constexpr u32 s_refit_steps = 5;
+
+    // twists the mesh around its vertical axis a little more every step, refitting the first tree each time.
+    // the decay metric is checked against the SAH of a fresh build of the same pose
+    auto bench_refit(const std::string& asset) -> void
+    {
+        Model model = Loader::load_obj(asset);
+        auto rest = Bvh::triangles_of(*model.mesh);
+
+        Bvh refitted = Bvh::build(rest);
+        Bounds bounds = refitted.bounds();
+        glm::vec3 center = bounds.center();
+        f32 height = std::max(bounds.extent().y, std::numeric_limits<f32>::min());
+
+        auto twist = [&](const glm::vec3& p, f32 amount) {
+            f32 angle = amount * (p.y - bounds.min.y) / height;
+            glm::vec3 d = p - center;
+            return center + glm::vec3(d.x * std::cos(angle) - d.z * std::sin(angle), d.y, d.x * std::sin(angle) + d.z * std::cos(angle));
+        };
+
+        std::println("refit: {} ({} triangles, rebuild above {:.2f}x)", asset, rest.size(), Bvh::s_RebuildThreshold);
+
+        std::vector<BvhTriangle> posed(rest.size());
+        for (u32 step = 1; step <= s_refit_steps; ++step) {
+            f32 amount = 0.25f * static_cast<f32>(step);
+            for (usize i = 0; i < rest.size(); ++i) {
+                posed[i] = BvhTriangle { twist(rest[i].v0, amount), twist(rest[i].v1, amount), twist(rest[i].v2, amount) };
+            }
+
+            f64 refit_ms = std::numeric_limits<f64>::max();
+            for (u32 i = 0; i < s_repeats; ++i) {
+                auto start = std::chrono::steady_clock::now();
+                refitted.refit(posed);
+                std::chrono::duration<f64, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+                refit_ms = std::min(refit_ms, elapsed.count());
+            }
+
+            auto rebuilt = timed_build(posed, BvhBuildOptions {});
+
+            std::println(" - twist {:.2f} rad: refit {:.2f} ms, rebuild {:.2f} ms, decay {:.2f}x{}, sah {:.2f} refitted vs {:.2f} rebuilt",
+                amount, refit_ms, rebuilt.best_ms, refitted.quality_decay(), refitted.should_rebuild() ? " (rebuild)" : "",
+                refitted.sah_cost(), rebuilt.bvh.sah_cost()
+            );
+
+            if (step == s_refit_steps) {
+                auto rays = primary_rays(rebuilt.bvh.bounds());
+
+                auto refit_trace = timed_trace(rays.size(), [&](std::span<Hit> hits) {
+                    for (usize i = 0; i < rays.size(); ++i) hits[i] = refitted.intersect(rays[i]);
+                });
+                auto rebuilt_trace = timed_trace(rays.size(), [&](std::span<Hit> hits) {
+                    for (usize i = 0; i < rays.size(); ++i) hits[i] = rebuilt.bvh.intersect(rays[i]);
+                });
+
+                std::println(" - last pose: {:.2f} Mrays/s refitted vs {:.2f} Mrays/s rebuilt", refit_trace.mrays, rebuilt_trace.mrays);
+
+                usize wrong = mismatches(refit_trace.hits, rebuilt_trace.hits);
+                if (wrong > 0) {
+                    std::println(std::cerr, "   {} hits differ between the refitted and rebuilt trees", wrong);
+                }
+            }
+        }
+    }
+
+    // one extra untimed run under the cache counter
+    template <typename Fn>
+    auto misses_per_ray(CacheMissCounter& counter, usize ray_count, Fn&& trace) -> f64
+    {
+        std::vector<Hit> hits(ray_count);
+
+        counter.start();
+        trace(std::span<Hit>(hits));
+        u64 misses = counter.stop();
+
+        return static_cast<f64>(misses) / static_cast<f64>(std::max<usize>(ray_count, 1));
+    }
+
+    // diffuse bounces traced depth first as each pixel produces them, against a wavefront that queues the whole
+    // bounce and traces it sorted by origin and direction
+    auto bench_wavefront(const Bvh& bvh, const WideBvh& wide, std::span<const Ray> secondary, std::span<const Hit> reference) -> void
+    {
+        CacheMissCounter counter;
+
+        auto per_pixel = [&](std::span<Hit> hits) {
+            for (usize i = 0; i < secondary.size(); ++i) hits[i] = bvh.intersect(secondary[i]);
+        };
+
+        auto wavefront = [&](bool sorted) {
+            return [&, sorted](std::span<Hit> hits) {
+                Wavefront queue(bvh.bounds(), WavefrontOptions { .sort = sorted });
+                for (usize i = 0; i < secondary.size(); ++i) queue.push(secondary[i], static_cast<u32>(i));
+                queue.trace(wide, hits);
+            };
+        };
+
+        auto depth_first = timed_trace(secondary.size(), per_pixel);
+        auto unsorted = timed_trace(secondary.size(), wavefront(false));
+        auto sorted = timed_trace(secondary.size(), wavefront(true));
+
+        Wavefront probe(bvh.bounds());
+        for (usize i = 0; i < secondary.size(); ++i) probe.push(secondary[i], static_cast<u32>(i));
+        std::vector<Hit> probe_hits(secondary.size());
+        probe.trace(wide, probe_hits);
+
+        std::println(" - wavefront ({} rays, sort {:.2f} ms):", secondary.size(), probe.stats().sort_ms);
+
+        auto report = [&](std::string_view name, const TraceResult& result, auto&& trace) {
+            if (counter.available()) {
+                std::println("   - {:<12} {:>7.2f} Mrays/s, {:.2f} cache misses/ray", name, result.mrays, misses_per_ray(counter, secondary.size(), trace));
+            } else {
+                std::println("   - {:<12} {:>7.2f} Mrays/s", name, result.mrays);
+            }
+
+            usize wrong = mismatches(result.hits, reference);
+            if (wrong > 0) {
+                std::println(std::cerr, "     {} hits differ from the scalar reference", wrong);
+            }
+        };
+
+        report("depth first", depth_first, per_pixel);
+        report("unsorted", unsorted, wavefront(false));
+        report("sorted", sorted, wavefront(true));
+
+        if (!counter.available()) {
+            std::println("   cache counters unavailable (perf events not permitted)");
+        }
+    }
+
+    // single threaded so the levels compare kernel against kernel
+    auto bench_traversal(const std::string& asset) -> void
+    {
+        Model model = Loader::load_obj(asset);
+
+        Bvh bvh = Bvh::build(*model.mesh);
+        WideBvh wide = WideBvh::build(bvh);
+
+        auto primary = primary_rays(bvh.bounds());
+
+        auto scalar_primary = timed_trace(primary.size(), [&](std::span<Hit> hits) {
+            for (usize i = 0; i < primary.size(); ++i) hits[i] = bvh.intersect(primary[i]);
+        });
+
+        auto secondary = secondary_rays(primary, scalar_primary.hits, glm::length(bvh.bounds().extent()) * 1e-5f);
+
+        auto scalar_secondary = timed_trace(secondary.size(), [&](std::span<Hit> hits) {
+            for (usize i = 0; i < secondary.size(); ++i) hits[i] = bvh.intersect(secondary[i]);
+        });
+
+        std::println("traversal: {} ({} primary, {} secondary rays, detected {})",
+            asset, primary.size(), secondary.size(), Traversal::name(Traversal::detect())
+        );
+        std::println(" - {:<8} primary {:>7.2f} Mrays/s, secondary {:>7.2f} Mrays/s", "scalar", scalar_primary.mrays, scalar_secondary.mrays);
+
+        for (SimdLevel level : { SimdLevel::Baseline, SimdLevel::Avx2, SimdLevel::Avx512 }) {
+            if (!Traversal::supported(level)) {
+                std::println(" - {:<8} not supported on this cpu", Traversal::name(level));
+                continue;
+            }
+
+            auto packets = timed_trace(primary.size(), [&](std::span<Hit> hits) {
+                Traversal::intersect_packets(bvh, primary, hits, level);
+            });
+            auto stream = timed_trace(secondary.size(), [&](std::span<Hit> hits) {
+                Traversal::intersect_stream(wide, secondary, hits, level);
+            });
+
+            std::println(" - {:<8} primary {:>7.2f} Mrays/s ({}-wide packets), secondary {:>7.2f} Mrays/s (8-wide nodes)",
+                Traversal::name(level), packets.mrays, Traversal::packet_width(level), stream.mrays
+            );
+
+            usize wrong = mismatches(packets.hits, scalar_primary.hits) + mismatches(stream.hits, scalar_secondary.hits);
+            if (wrong > 0) {
+                std::println(std::cerr, "   {} hits differ from the scalar reference", wrong);
+            }
+        }
+
+        bench_compressed(bvh, wide, secondary, scalar_secondary.hits);
+        bench_wavefront(bvh, wide, secondary, scalar_secondary.hits);
+        bench_spatial(Bvh::triangles_of(*model.mesh), primary, secondary);
+    }
+
+    // suite shots are smaller than the studies above so a full run fits a CI budget
+    constexpr u32 s_suite_width = 640;
+    constexpr u32 s_suite_height = 360;
+
+    // eye, target and light are fractions of the scene bounds, so the shots do not depend on the asset's units
+    struct CameraScript
+    {
+        std::string name;
+        glm::vec3 eye;
+        glm::vec3 target;
+        // vertical, degrees
+        f32 fov;
+    };
+
+    struct SceneScript
+    {
+        std::string asset;
+        std::vector<CameraScript> cameras;
+        glm::vec3 light;
+    };
+
+    auto suite_scripts() -> std::vector<SceneScript>
+    {
+        return {
+            SceneScript {
+                .asset = "assets/sponza/sponza.obj",
+                .cameras = {
+                    { .name = "atrium", .eye = glm::vec3(0.1f, 0.15f, 0.5f), .target = glm::vec3(0.9f, 0.3f, 0.5f), .fov = 60.0f },
+                    { .name = "colonnade", .eye = glm::vec3(0.5f, 0.1f, 0.2f), .target = glm::vec3(0.9f, 0.15f, 0.25f), .fov = 50.0f },
+                    { .name = "roof", .eye = glm::vec3(0.5f, 0.9f, 0.5f), .target = glm::vec3(0.5f, 0.0f, 0.55f), .fov = 70.0f }
+                },
+                .light = glm::vec3(0.55f, 0.98f, 0.45f)
+            },
+            SceneScript {
+                .asset = "assets/teapot.obj",
+                .cameras = {
+                    { .name = "front", .eye = glm::vec3(0.5f, 0.7f, -1.5f), .target = glm::vec3(0.5f, 0.4f, 0.5f), .fov = 45.0f },
+                    { .name = "close", .eye = glm::vec3(1.2f, 0.9f, 0.1f), .target = glm::vec3(0.6f, 0.5f, 0.5f), .fov = 40.0f }
+                },
+                .light = glm::vec3(1.5f, 3.0f, -1.0f)
+            }
+        };
+    }
+
+    auto scene_point(const Bounds& bounds, const glm::vec3& fraction) -> glm::vec3
+    {
+        return bounds.min + (bounds.max - bounds.min) * fraction;
+    }
+
+    // y up pinhole, emitted in 4x4 pixel blocks like primary_rays
+    auto camera_rays(const Bounds& bounds, const CameraScript& camera) -> std::vector<Ray>
+    {
+        std::vector<Ray> rays;
+        rays.reserve(static_cast<usize>(s_suite_width) * s_suite_height);
+
+        glm::vec3 eye = scene_point(bounds, camera.eye);
+        glm::vec3 forward = glm::normalize(scene_point(bounds, camera.target) - eye);
+        glm::vec3 right = glm::normalize(glm::cross(forward, glm::vec3(0.0f, 1.0f, 0.0f)));
+        glm::vec3 up = glm::cross(right, forward);
+
+        f32 half_height = std::tan(glm::radians(camera.fov) * 0.5f);
+        f32 half_width = half_height * static_cast<f32>(s_suite_width) / static_cast<f32>(s_suite_height);
+
+        for (u32 by = 0; by < s_suite_height; by += s_block_size) {
+            for (u32 bx = 0; bx < s_suite_width; bx += s_block_size) {
+                for (u32 y = by; y < std::min(by + s_block_size, s_suite_height); ++y) {
+                    for (u32 x = bx; x < std::min(bx + s_block_size, s_suite_width); ++x) {
+                        f32 u = (static_cast<f32>(x) + 0.5f) / static_cast<f32>(s_suite_width) * 2.0f - 1.0f;
+                        f32 v = 1.0f - (static_cast<f32>(y) + 0.5f) / static_cast<f32>(s_suite_height) * 2.0f;
+
+                        rays.push_back(Ray {
+                            .origin = eye,
+                            .direction = glm::normalize(forward + right * (u * half_width) + up * (v * half_height)),
+                            .tmin = 0.0f,
+                            .tmax = std::numeric_limits<f32>::max()
+                        });
+                    }
+                }
+            }
+        }
+
+        return rays;
+    }
+
+    // from every primary hit towards the light, tmax stops just short of it. misses get no ray
+    auto shadow_rays(std::span<const Ray> primary, std::span<const Hit> hits, const glm::vec3& light, f32 epsilon) -> std::vector<Ray>
+    {
+        std::vector<Ray> rays;
+        rays.reserve(primary.size());
+
+        for (usize i = 0; i < primary.size(); ++i) {
+            if (!hits[i].valid()) continue;
+
+            glm::vec3 origin = primary[i].origin + primary[i].direction * hits[i].t;
+            glm::vec3 to_light = light - origin;
+            f32 distance = glm::length(to_light);
+
+            rays.push_back(Ray {
+                .origin = origin,
+                .direction = to_light / distance,
+                .tmin = epsilon,
+                .tmax = distance - epsilon
+            });
+        }
+
+        return rays;
+    }
+
+    // cosine weighted around the geometric normal facing the camera, the bounce a diffuse path tracer would take
+    auto diffuse_rays(std::span<const Ray> primary, std::span<const Hit> hits, std::span<const BvhTriangle> triangles, f32 epsilon) -> std::vector<Ray>
+    {
+        std::vector<Ray> rays;
+        rays.reserve(primary.size());
+
+        std::mt19937 rng(23);
+        std::uniform_real_distribution<f32> uniform(0.0f, 1.0f);
+
+        for (usize i = 0; i < primary.size(); ++i) {
+            if (!hits[i].valid()) continue;
+
+            const auto& triangle = triangles[hits[i].primitive];
+            glm::vec3 normal = glm::normalize(glm::cross(triangle.v1 - triangle.v0, triangle.v2 - triangle.v0));
+            if (glm::dot(normal, primary[i].direction) > 0.0f) normal = -normal;
+
+            // any orthonormal frame will do for a fixed ray set
+            glm::vec3 helper = std::abs(normal.x) > 0.9f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+            glm::vec3 tangent = glm::normalize(glm::cross(helper, normal));
+            glm::vec3 bitangent = glm::cross(normal, tangent);
+
+            f32 r = std::sqrt(uniform(rng));
+            f32 phi = uniform(rng) * 2.0f * std::numbers::pi_v<f32>;
+            f32 z = std::sqrt(std::max(0.0f, 1.0f - r * r));
+
+            rays.push_back(Ray {
+                .origin = primary[i].origin + primary[i].direction * hits[i].t,
+                .direction = tangent * (r * std::cos(phi)) + bitangent * (r * std::sin(phi)) + normal * z,
+                .tmin = epsilon,
+                .tmax = std::numeric_limits<f32>::max()
+            });
+        }
+
+        return rays;
+    }
+
+    auto hit_count(std::span<const Hit> hits) -> usize
+    {
+        return std::ranges::count_if(hits, [](const Hit& hit) { return hit.valid(); });
+    }
+
+    // for shadow rays only whether something was hit matters
+    auto occlusion_mismatches(std::span<const Hit> hits, std::span<const Hit> reference) -> usize
+    {
+        usize count = 0;
+        for (usize i = 0; i < hits.size(); ++i) {
+            if (hits[i].valid() != reference[i].valid()) count++;
+        }
+        return count;
+    }
+
+    auto record_trace(SceneRecord& scene, const std::string& camera, std::string_view rays, std::string_view method, const TraceResult& result) -> void
+    {
+        auto& trace = scene.traces.emplace_back(TraceRecord {
+            .camera = camera,
+            .rays = std::string(rays),
+            .method = std::string(method),
+            .ray_count = result.hits.size(),
+            .hit_count = hit_count(result.hits),
+            .mrays = result.mrays
+        });
+
+        std::println(" - {:<10} {:<8} {:<9} {:>7} rays, {:>5.1f}% hit, {:>7.2f} Mrays/s",
+            trace.camera, trace.rays, trace.method, trace.ray_count,
+            trace.ray_count > 0 ? static_cast<f64>(trace.hit_count) / static_cast<f64>(trace.ray_count) * 100.0 : 0.0, trace.mrays
+        );
+    }
+
+    auto report_mismatches(usize wrong, std::string_view what) -> void
+    {
+        if (wrong > 0) {
+            std::println(std::cerr, "   {} {} differ from the scalar reference", wrong, what);
+        }
+    }
+
+    // fixed shots of every asset traced the same way each run: the scalar intersector as the portable reference and
+    // the vectorized kernels at the detected level, single threaded so results compare across machines
+    auto run_suite(BenchReport& report) -> void
+    {
+        for (const auto& script : suite_scripts()) {
+            SceneRecord scene { .asset = script.asset };
+
+            // cold imports, optimizes and writes the cache, warm maps the file it just wrote
+            Loader::evict_cache(script.asset);
+
+            auto start = std::chrono::steady_clock::now();
+            Loader::load_obj(script.asset);
+            scene.cold_load_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            start = std::chrono::steady_clock::now();
+            Model model = Loader::load_obj(script.asset);
+            scene.warm_load_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            scene.import_mb_s = parse_throughput(script.asset);
+
+            auto triangles = Bvh::triangles_of(*model.mesh);
+            scene.triangles = triangles.size();
+
+            auto built = timed_build(triangles, BvhBuildOptions {});
+            const Bvh& bvh = built.bvh;
+            scene.build_ms = built.best_ms;
+            scene.sah_cost = bvh.sah_cost();
+
+            start = std::chrono::steady_clock::now();
+            WideBvh wide = WideBvh::build(bvh);
+            scene.wide_build_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            scene.bvh_bytes = bvh.memory_size() + wide.nodes().size_bytes() + wide.primitives().size_bytes() + wide.triangles().size_bytes();
+
+            std::println("suite: {} ({} triangles), load {:.2f} ms cold / {:.2f} ms warm, parse {:.1f} MB/s, build {:.2f} ms + {:.2f} ms wide, {:.2f} MiB",
+                scene.asset, scene.triangles, scene.cold_load_ms, scene.warm_load_ms, scene.import_mb_s, scene.build_ms, scene.wide_build_ms, mebibytes(scene.bvh_bytes)
+            );
+
+            Bounds bounds = bvh.bounds();
+            f32 epsilon = glm::length(bounds.extent()) * 1e-5f;
+            glm::vec3 light = scene_point(bounds, script.light);
+
+            for (const auto& camera : script.cameras) {
+                auto primary = camera_rays(bounds, camera);
+
+                auto primary_scalar = timed_trace(primary.size(), [&](std::span<Hit> hits) {
+                    for (usize i = 0; i < primary.size(); ++i) hits[i] = bvh.intersect(primary[i]);
+                });
+                auto primary_packets = timed_trace(primary.size(), [&](std::span<Hit> hits) {
+                    Traversal::intersect_packets(bvh, primary, hits);
+                });
+
+                record_trace(scene, camera.name, "primary", "scalar", primary_scalar);
+                record_trace(scene, camera.name, "primary", "packets", primary_packets);
+                report_mismatches(mismatches(primary_packets.hits, primary_scalar.hits), "primary hits");
+
+                auto shadow = shadow_rays(primary, primary_scalar.hits, light, epsilon);
+
+                // occlusion is stored as a hit so both methods are counted the same way
+                auto shadow_scalar = timed_trace(shadow.size(), [&](std::span<Hit> hits) {
+                    for (usize i = 0; i < shadow.size(); ++i) {
+                        if (bvh.occluded(shadow[i])) hits[i].primitive = 0;
+                    }
+                });
+                auto shadow_stream = timed_trace(shadow.size(), [&](std::span<Hit> hits) {
+                    Traversal::intersect_stream(wide, shadow, hits);
+                });
+
+                record_trace(scene, camera.name, "shadow", "scalar", shadow_scalar);
+                record_trace(scene, camera.name, "shadow", "stream", shadow_stream);
+                report_mismatches(occlusion_mismatches(shadow_stream.hits, shadow_scalar.hits), "shadow results");
+
+                auto diffuse = diffuse_rays(primary, primary_scalar.hits, triangles, epsilon);
+
+                auto diffuse_scalar = timed_trace(diffuse.size(), [&](std::span<Hit> hits) {
+                    for (usize i = 0; i < diffuse.size(); ++i) hits[i] = bvh.intersect(diffuse[i]);
+                });
+                auto diffuse_stream = timed_trace(diffuse.size(), [&](std::span<Hit> hits) {
+                    Traversal::intersect_stream(wide, diffuse, hits);
+                });
+                auto diffuse_sorted = timed_trace(diffuse.size(), [&](std::span<Hit> hits) {
+                    Wavefront queue(bounds);
+                    for (usize i = 0; i < diffuse.size(); ++i) queue.push(diffuse[i], static_cast<u32>(i));
+                    queue.trace(wide, hits);
+                });
+
+                record_trace(scene, camera.name, "diffuse", "scalar", diffuse_scalar);
+                record_trace(scene, camera.name, "diffuse", "stream", diffuse_stream);
+                record_trace(scene, camera.name, "diffuse", "wavefront", diffuse_sorted);
+                report_mismatches(mismatches(diffuse_stream.hits, diffuse_scalar.hits) + mismatches(diffuse_sorted.hits, diffuse_scalar.hits), "diffuse hits");
+            }
+
+            report.add_scene(std::move(scene));
+        }
+    }
+
+    struct BenchOptions
+    {
+        std::string json;
+        // output of RTX --headless --json, embedded as the report's gpu section
+        std::string gpu;
+        // skips the studies after the suite
+        bool suite_only { false };
+    };
+
+    auto parse_options(std::span<char*> args, BenchOptions& options) -> bool
+    {
+        for (usize i = 0; i < args.size(); ++i) {
+            std::string_view arg = args[i];
+
+            if (arg == "--suite-only") {
+                options.suite_only = true;
+            } else if (arg == "--json" && i + 1 < args.size()) {
+                options.json = args[++i];
+            } else if (arg == "--gpu" && i + 1 < args.size()) {
+                options.gpu = args[++i];
+            } else {
+                std::println(std::cerr, "unknown option {}", arg);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+}
+
+auto main(i32 argc, char** argv) -> i32
+{
+    BenchOptions options;
+    if (!parse_options(std::span<char*>(argv + 1, static_cast<usize>(std::max(argc - 1, 0))), options)) {
+        std::println(std::cerr, "usage: rtx_bench [--json file] [--gpu file] [--suite-only]");
+        return 1;
+    }
+
+    BenchReport report;
+    if (!options.gpu.empty() && !report.load_gpu(options.gpu)) {
+        return 1;
+    }
+
+    run_suite(report);
+
+    if (!options.json.empty() && !report.write_json(options.json)) {
+        return 1;
+    }
+
+    if (options.suite_only) {
+        return 0;
+    }
+
+    const std::vector<std::string> assets {
+        "assets/sponza/sponza.obj",
+        "assets/teapot.obj"
+    };
+
+    for (const auto& asset : assets) {
+        bench_bvh(asset);
+    }
+
+    for (const auto& asset : assets) {
+        bench_traversal(asset);
+    }
+
+    bench_instances("assets/teapot.obj");
+
+    for (const auto& asset : assets) {
+        bench_refit(asset);
+    }
+}
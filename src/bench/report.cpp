@@ -0,0 +1,134 @@
+#include "report.hpp"
+
+#include "scene/traversal.hpp"
+#include "platform/memory.hpp"
+
+namespace {
+
+    // the benchmark links no Vulkan, device build and trace numbers come from a headless run of the app
+    constexpr std::string_view s_gpu_unavailable = "rtx_bench is host only, run RTX --headless --json file and pass the file with --gpu";
+
+    // asset paths and the fixed names used here, only quotes and backslashes need escaping
+    auto quoted(std::string_view text) -> std::string
+    {
+        std::string result = "\"";
+        for (char c : text) {
+            if (c == '"' || c == '\\') result += '\\';
+            result += c;
+        }
+        result += '"';
+        return result;
+    }
+
+}
+
+BenchReport::BenchReport()
+    : m_simd(Traversal::name(Traversal::detect())), m_threads(std::max(1u, std::thread::hardware_concurrency()))
+{
+}
+
+auto BenchReport::add_scene(SceneRecord scene) -> void
+{
+    m_scenes.push_back(std::move(scene));
+    m_peak_memory = std::max(m_peak_memory, peak_memory_usage());
+}
+
+auto BenchReport::load_gpu(const std::filesystem::path& path) -> bool
+{
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::println(std::cerr, "BenchReport: failed to open {}", path.string());
+        return false;
+    }
+
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    usize key = text.find("\"gpu\"");
+    usize begin = (key == std::string::npos) ? key : text.find('{', key);
+    if (begin == std::string::npos) {
+        std::println(std::cerr, "BenchReport: no gpu object in {}", path.string());
+        return false;
+    }
+
+    // matching brace of the object, braces inside strings do not count
+    i32 depth = 0;
+    bool in_string = false;
+    for (usize i = begin; i < text.size(); ++i) {
+        char c = text[i];
+
+        if (in_string) {
+            if (c == '\\') ++i;
+            else if (c == '"') in_string = false;
+            continue;
+        }
+
+        if (c == '"') in_string = true;
+        else if (c == '{') depth++;
+        else if (c == '}' && --depth == 0) {
+            m_gpu = text.substr(begin, i - begin + 1);
+            return true;
+        }
+    }
+
+    std::println(std::cerr, "BenchReport: unterminated gpu object in {}", path.string());
+    return false;
+}
+
+auto BenchReport::write_json(const std::filesystem::path& path) const -> bool
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) {
+        std::println(std::cerr, "BenchReport: failed to open {}", path.string());
+        return false;
+    }
+
+    file << "{\n";
+    file << std::format("  \"simd\": {},\n", quoted(m_simd));
+    file << std::format("  \"hardware_threads\": {},\n", m_threads);
+    file << std::format("  \"peak_memory_bytes\": {},\n", m_peak_memory);
+    if (m_gpu.empty()) {
+        file << "  \"gpu\": null,\n";
+        file << std::format("  \"gpu_reason\": {},\n", quoted(s_gpu_unavailable));
+    } else {
+        file << std::format("  \"gpu\": {},\n", m_gpu);
+    }
+    file << "  \"scenes\": [\n";
+
+    for (usize s = 0; s < m_scenes.size(); ++s) {
+        const auto& scene = m_scenes[s];
+
+        file << "    {\n";
+        file << std::format("      \"asset\": {},\n", quoted(scene.asset));
+        file << std::format("      \"triangles\": {},\n", scene.triangles);
+        file << std::format("      \"cold_load_ms\": {:.3f},\n", scene.cold_load_ms);
+        file << std::format("      \"warm_load_ms\": {:.3f},\n", scene.warm_load_ms);
+        file << std::format("      \"import_mb_s\": {:.3f},\n", scene.import_mb_s);
+        file << std::format("      \"build_ms\": {:.3f},\n", scene.build_ms);
+        file << std::format("      \"wide_build_ms\": {:.3f},\n", scene.wide_build_ms);
+        file << std::format("      \"bvh_bytes\": {},\n", scene.bvh_bytes);
+        file << std::format("      \"sah_cost\": {:.3f},\n", scene.sah_cost);
+        file << "      \"traces\": [\n";
+
+        for (usize t = 0; t < scene.traces.size(); ++t) {
+            const auto& trace = scene.traces[t];
+
+            file << std::format("        {{ \"camera\": {}, \"rays\": {}, \"method\": {}, \"ray_count\": {}, \"hit_count\": {}, \"mrays\": {:.3f} }}{}\n",
+                quoted(trace.camera), quoted(trace.rays), quoted(trace.method), trace.ray_count, trace.hit_count, trace.mrays,
+                t + 1 < scene.traces.size() ? "," : ""
+            );
+        }
+
+        file << "      ]\n";
+        file << std::format("    }}{}\n", s + 1 < m_scenes.size() ? "," : "");
+    }
+
+    file << "  ]\n";
+    file << "}\n";
+
+    if (!file.good()) {
+        std::println(std::cerr, "BenchReport: failed to write {}", path.string());
+        return false;
+    }
+
+    return true;
+}
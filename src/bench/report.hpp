@@ -0,0 +1,60 @@
+#pragma once
+
+// one ray set traced one way from one camera
+struct TraceRecord
+{
+    std::string camera;
+    // primary, shadow or diffuse
+    std::string rays;
+    // scalar, packets or stream
+    std::string method;
+
+    usize ray_count { 0 };
+    // rays that hit something, or were occluded for shadow rays
+    usize hit_count { 0 };
+    f64 mrays { 0.0 };
+};
+
+struct SceneRecord
+{
+    std::string asset;
+    usize triangles { 0 };
+
+    // with the mesh cache evicted first, then straight after from the cache that load wrote
+    f64 cold_load_ms { 0.0 };
+    f64 warm_load_ms { 0.0 };
+    // obj parser throughput over the source file, in MiB/s
+    f64 import_mb_s { 0.0 };
+    f64 build_ms { 0.0 };
+    f64 wide_build_ms { 0.0 };
+    // binary and wide tree together
+    usize bvh_bytes { 0 };
+    f32 sah_cost { 0.0f };
+
+    std::vector<TraceRecord> traces;
+};
+
+// results of the scripted suite, printed as it runs and written as JSON at the end so runs can be diffed
+class BenchReport
+{
+public:
+    BenchReport();
+
+    // also samples the process peak memory, so add scenes as soon as they are done
+    auto add_scene(SceneRecord scene) -> void;
+    [[nodiscard]] auto scenes() const -> std::span<const SceneRecord> { return m_scenes; }
+
+    // takes the "gpu" object of a file written by RTX --headless --json, the report has no device section without one
+    auto load_gpu(const std::filesystem::path& path) -> bool;
+
+    auto write_json(const std::filesystem::path& path) const -> bool;
+
+private:
+    std::string m_simd;
+    u32 m_threads { 0 };
+    u64 m_peak_memory { 0 };
+    // copied verbatim, empty when no device timings were loaded
+    std::string m_gpu;
+
+    std::vector<SceneRecord> m_scenes;
+};
@@ -2,19 +2,33 @@
 
 #include "rhi/barrier.hpp"
 #include "rhi/acceleration_structure.hpp"
-// #include "rhi/shader.hpp"
+#include "rhi/shader.hpp"
 
 #include "scene/loader.hpp"
 
-Application::Application()
+#include "cpu/image_writer.hpp"
+
+Application::Application(const ApplicationOptions& options)
+    : m_options(options), m_start(std::chrono::steady_clock::now())
 {
-    m_window = std::make_unique<Window>(1280, 720, "RTX");
-    m_window->bind_event_callback(BIND_EVENT_FN(Application::dispatch_events));
+    VkExtent2D extent { options.width, options.height };
+
+    if (!options.headless) {
+        m_window = std::make_unique<Window>(options.width, options.height, "RTX");
+        m_window->bind_event_callback(BIND_EVENT_FN(Application::dispatch_events));
+
+        extent = VkExtent2D { m_window->width(), m_window->height() };
+    }
+
+    m_context = std::make_shared<RHI::Context>(m_window ? m_window->native() : nullptr);
+    m_device = std::make_shared<RHI::Device>(m_context, options.device);
 
-    m_context = std::make_shared<RHI::Context>(m_window->native());
-    m_device = std::make_shared<RHI::Device>(m_context);
+    m_pipeline_cache = std::make_unique<RHI::PipelineCache>(m_device, options.cold_pipeline_cache);
 
-    m_swapchain = std::make_unique<RHI::Swapchain>(m_context, m_device, VkExtent2D { m_window->width(), m_window->height() });
+    if (!options.headless) {
+        m_swapchain = std::make_unique<RHI::Swapchain>(m_context, m_device, extent);
+        extent = VkExtent2D { m_swapchain->width(), m_swapchain->height() };
+    }
 
     m_graphics_command = std::make_unique<RHI::Command>(m_device, m_device->graphics_index(), s_FramesInFlight);
     m_compute_command = std::make_unique<RHI::Command>(m_device, m_device->compute_index(), s_FramesInFlight);
@@ -24,9 +38,12 @@ Application::Application()
     m_compute_queue = std::make_unique<RHI::Queue>(m_device, m_device->compute_index());
     m_transfer_queue = std::make_unique<RHI::Queue>(m_device, m_device->transfer_index());
 
+    // one queue doing both, or async compute turned off: there is nothing to overlap, record the frame in one submission
+    m_merge_submissions = !options.async_compute || m_compute_queue->aliases(*m_graphics_queue);
+
     m_storage = std::make_unique<RHI::Image>(
         m_device,
-        VkExtent3D { m_swapchain->width(), m_swapchain->height(), 1 },
+        VkExtent3D { extent.width, extent.height, 1 },
         VK_FORMAT_R32G32B32A32_SFLOAT,
         VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT
     );
@@ -48,12 +65,18 @@ Application::~Application()
 
 auto Application::run() -> void
 {
-    load_scene();
+    if (m_options.headless) {
+        run_headless();
+        return;
+    }
+
+    // the pipeline comes first so the benchmarks after loading can trace
     build_rt_pipeline();
+    load_scene();
+    share_scene_with_graphics();
 
-    // auto raygen_shader = std::make_unique<RHI::Shader>(m_device, "raygen.rgen.spv", VK_SHADER_STAGE_RAYGEN_BIT_KHR);
-    // auto closesthit_shader = std::make_unique<RHI::Shader>(m_device, "closesthit.rchit.spv", VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR);
-    // auto miss_shader = std::make_unique<RHI::Shader>(m_device, "miss.rmiss.spv", VK_SHADER_STAGE_MISS_BIT_KHR);
+    // loading may have submitted to the graphics queue, frame values count on from there
+    u64 frame_base = m_graphics_queue->value();
 
     while (m_running) {
         Window::poll_events();
@@ -62,7 +85,7 @@ auto Application::run() -> void
             // sync frames in flight
 
             if (m_frame_count >= s_FramesInFlight) {
-                u64 wait_value = m_frame_count - s_FramesInFlight + 1;
+                u64 wait_value = frame_base + m_frame_count - s_FramesInFlight + 1;
                 m_graphics_queue->sync(wait_value);
             }
 
@@ -75,58 +98,55 @@ auto Application::run() -> void
                 continue;
             }
 
-            // descriptor set
-
-            m_descriptor_allocators[frame_index]->reset();
-
-            VkDescriptorSet rt_set = m_descriptor_allocators[frame_index]->allocate(*m_rt_descriptor_layout);
-            RHI::DescriptorWriter(m_device)
-                .write_as(0, *m_tlas)
-                .write_storage_image(1, *m_storage)
-                .update(rt_set);
-
             // record commands
 
-            auto compute_cmd = m_compute_command->begin();
-
-            u32 storage_src_queue = (m_frame_count == 0) ? VK_QUEUE_FAMILY_IGNORED : m_device->graphics_index();
-            u32 storage_dst_queue = (m_frame_count == 0) ? VK_QUEUE_FAMILY_IGNORED : m_device->compute_index();
-
-            VkImageLayout storage_old_layout = (m_frame_count == 0) ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-
-            RHI::BarrierBatch(compute_cmd)
-                .image(*m_storage,
-                    VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_NONE,
-                    VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
-                    storage_old_layout, VK_IMAGE_LAYOUT_GENERAL,
-                    VK_IMAGE_ASPECT_COLOR_BIT,
-                    storage_src_queue, storage_dst_queue
-                )
-                .insert();
+            auto graphics_cmd = m_graphics_command->begin();
+            auto compute_cmd = m_merge_submissions ? graphics_cmd : m_compute_command->begin();
+
+            u32 graphics_family = m_graphics_queue->family();
+            u32 compute_family = m_merge_submissions ? graphics_family : m_compute_queue->family();
+
+            if (m_frame_count == 0) {
+                RHI::BarrierBatch(compute_cmd)
+                    .image(*m_storage,
+                        VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE,
+                        VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
+                        VK_IMAGE_ASPECT_COLOR_BIT
+                    )
+                    .insert();
+            } else {
+                RHI::BarrierBatch(compute_cmd)
+                    .acquire_image(*m_storage,
+                        VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL,
+                        VK_IMAGE_ASPECT_COLOR_BIT,
+                        graphics_family, compute_family
+                    )
+                    .insert();
+            }
 
-            // TODO: bind rt pipeline && dispatch rays
+            trace_rays(compute_cmd, frame_index, *m_tlas);
 
             RHI::BarrierBatch(compute_cmd)
-                .image(*m_storage,
+                .release_image(*m_storage,
                     VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
-                    VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_NONE,
                     VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
                     VK_IMAGE_ASPECT_COLOR_BIT,
-                    m_device->compute_index(), m_device->graphics_index()
+                    compute_family, graphics_family
                 )
                 .insert();
 
-            m_compute_command->end(compute_cmd);
-
-            auto graphics_cmd = m_graphics_command->begin();
+            if (!m_merge_submissions) {
+                m_compute_command->end(compute_cmd);
+            }
 
             RHI::BarrierBatch(graphics_cmd)
-                .image(*m_storage,
-                    VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_2_NONE,
+                .acquire_image(*m_storage,
                     VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT,
                     VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
                     VK_IMAGE_ASPECT_COLOR_BIT,
-                    m_device->compute_index(), m_device->graphics_index()
+                    compute_family, graphics_family
                 )
                 .image(m_swapchain->current_image(),
                     VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_NONE,
@@ -136,6 +156,17 @@ auto Application::run() -> void
                 )
                 .insert();
 
+            // in one submission the release above is an ordinary barrier that only covers the trace, the blit still
+            // has to wait for it
+            if (m_merge_submissions) {
+                RHI::BarrierBatch(graphics_cmd)
+                    .memory(
+                        VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_NONE,
+                        VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT
+                    )
+                    .insert();
+            }
+
             VkImageBlit blit_region {
                 .srcSubresource = {
                     .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
@@ -167,12 +198,11 @@ auto Application::run() -> void
             );
 
             RHI::BarrierBatch(graphics_cmd)
-                .image(*m_storage,
-                    VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT,
-                    VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_2_NONE,
+                .release_image(*m_storage,
+                    VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_NONE,
                     VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL,
                     VK_IMAGE_ASPECT_COLOR_BIT,
-                    m_device->graphics_index(), m_device->compute_index()
+                    graphics_family, compute_family
                 )
                 .image(m_swapchain->current_image(),
                     VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
@@ -186,19 +216,22 @@ auto Application::run() -> void
 
             // submit commands
 
-            std::vector<VkSemaphoreSubmitInfo> compute_waits;
-            std::vector<VkSemaphoreSubmitInfo> compute_signals;
+            std::vector<VkSemaphoreSubmitInfo> graphics_waits {
+                m_swapchain->acquire_wait_info()
+            };
 
-            if (m_frame_count > 0) {
-                compute_waits.push_back(m_graphics_queue->wait_info(VK_PIPELINE_STAGE_2_TRANSFER_BIT));
-            }
+            if (!m_merge_submissions) {
+                std::vector<VkSemaphoreSubmitInfo> compute_waits;
+                std::vector<VkSemaphoreSubmitInfo> compute_signals;
 
-            u64 compute_signal_value = m_compute_queue->submit(compute_cmd, compute_waits, compute_signals);
+                if (m_frame_count > 0) {
+                    compute_waits.push_back(m_graphics_queue->wait_info(VK_PIPELINE_STAGE_2_TRANSFER_BIT));
+                }
 
-            std::vector<VkSemaphoreSubmitInfo> graphics_waits {
-                m_swapchain->acquire_wait_info(),
-                m_compute_queue->wait_info()
-            };
+                m_compute_queue->submit(compute_cmd, compute_waits, compute_signals);
+
+                graphics_waits.push_back(m_compute_queue->wait_info());
+            }
 
             std::vector<VkSemaphoreSubmitInfo> graphics_signals {
                 m_swapchain->present_signal_info()
@@ -212,6 +245,10 @@ auto Application::run() -> void
                 m_swapchain->recreate(VkExtent2D { m_window->width(), m_window->height() });
             }
 
+            if (m_frame_count == 0) {
+                report_first_frame(*m_graphics_queue, graphics_signal_value);
+            }
+
             m_frame_count++;
         }
     }
@@ -219,26 +256,93 @@ auto Application::run() -> void
 
 auto Application::load_scene() -> void
 {
+    auto start = std::chrono::steady_clock::now();
+
+    const std::vector<std::string> assets {
+        "assets/sponza/sponza.obj",
+        "assets/teapot.obj"
+    };
+
+    // parse and optimize every model on its own worker, record uploads as each one lands
+
+    const LoadOptions load_options {
+        .lod_count = 4,
+        .cluster_triangles = 1 << 16
+    };
+
+    LoadBatch batch(assets, load_options);
+
+    std::vector<Model> models(assets.size());
+    std::vector<std::unique_ptr<RHI::Buffer>> vertex_buffers(assets.size());
+    std::vector<std::unique_ptr<RHI::Buffer>> index_buffers(assets.size());
+    std::vector<std::unique_ptr<RHI::Buffer>> transform_buffers(assets.size());
+
+    std::vector<VkFormat> vertex_formats(assets.size(), VK_FORMAT_R32G32B32_SFLOAT);
+    std::vector<u32> vertex_strides(assets.size(), sizeof(Vertex));
+
     std::vector<std::unique_ptr<RHI::Buffer>> staging_buffers;
 
     auto upload_cmd = m_transfer_command->begin();
 
-    auto sponza = Loader::load_obj("assets/sponza/sponza.obj");
-    auto sponza_vb = RHI::Buffer::create_staged(m_device, upload_cmd, sponza.mesh->vertices.data(), sponza.mesh->vertices.size() * sizeof(Vertex), VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR, staging_buffers);
-    auto sponza_ib = RHI::Buffer::create_staged(m_device, upload_cmd, sponza.mesh->indices.data(), sponza.mesh->indices.size() * sizeof(u32), VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, staging_buffers);
+    while (auto loaded = batch.next()) {
+        auto& [i, model] = *loaded;
+
+        models[i] = std::move(model);
+        const auto& mesh = *models[i].mesh;
+
+        // split meshes hand the builder only their packed positions. the hit shader shades from barycentrics
+        // alone, so the attribute stream stays on the host until something binds it
+
+        if (mesh.layout == VertexLayout::Split) {
+            vertex_buffers[i] = RHI::Buffer::create_staged(m_device, upload_cmd, mesh.positions.data(), mesh.positions.size_bytes(), VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR, staging_buffers);
+            vertex_strides[i] = sizeof(glm::vec3);
+        } else if (mesh.layout == VertexLayout::Compact) {
+            VkFormat format = (mesh.position_format == PositionFormat::Float16) ? VK_FORMAT_R16G16B16A16_SFLOAT : VK_FORMAT_R16G16B16A16_SNORM;
+
+            if (m_device->supports_as_vertex_format(format)) {
+                // the builder reads the 16 bit positions directly, the geometry transform maps them back into mesh space
+                VkTransformMatrixKHR transform = vkutils::glm_to_vkmatrix(mesh.dequantize_transform());
+
+                vertex_buffers[i] = RHI::Buffer::create_staged(m_device, upload_cmd, mesh.compact_positions.data(), mesh.compact_positions.size_bytes(), VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR, staging_buffers);
+                transform_buffers[i] = RHI::Buffer::create_staged(m_device, upload_cmd, &transform, sizeof(VkTransformMatrixKHR), VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR, staging_buffers);
+                vertex_formats[i] = format;
+                vertex_strides[i] = sizeof(CompactPosition);
+            } else {
+                std::vector<glm::vec3> positions(mesh.vertex_count());
+                for (usize v = 0; v < positions.size(); ++v) {
+                    positions[v] = mesh.position(v);
+                }
 
-    auto teapot = Loader::load_obj("assets/teapot.obj");
-    auto teapot_vb = RHI::Buffer::create_staged(m_device, upload_cmd, teapot.mesh->vertices.data(), teapot.mesh->vertices.size() * sizeof(Vertex), VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR, staging_buffers);
-    auto teapot_ib = RHI::Buffer::create_staged(m_device, upload_cmd, teapot.mesh->indices.data(), teapot.mesh->indices.size() * sizeof(u32), VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, staging_buffers);
+                vertex_buffers[i] = RHI::Buffer::create_staged(m_device, upload_cmd, positions.data(), positions.size() * sizeof(glm::vec3), VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR, staging_buffers);
+                vertex_strides[i] = sizeof(glm::vec3);
+
+                std::println("{}: no acceleration structure support for 16 bit positions, decoded on the host", assets[i]);
+            }
+
+            // encoded normals and uvs stay on the host like the split attribute stream
+        } else {
+            vertex_buffers[i] = RHI::Buffer::create_staged(m_device, upload_cmd, mesh.vertices.data(), mesh.vertices.size_bytes(), VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR, staging_buffers);
+        }
+
+        index_buffers[i] = RHI::Buffer::create_staged(m_device, upload_cmd, mesh.indices.data(), mesh.indices.size_bytes(), VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, staging_buffers);
+    }
 
     // relase ownership
 
-    RHI::BarrierBatch(upload_cmd)
-        .buffer(*sponza_vb, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_NONE, m_device->transfer_index(), m_device->compute_index())
-        .buffer(*sponza_ib, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_NONE, m_device->transfer_index(), m_device->compute_index())
-        .buffer(*teapot_vb, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_NONE, m_device->transfer_index(), m_device->compute_index())
-        .buffer(*teapot_ib, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_NONE, m_device->transfer_index(), m_device->compute_index())
-        .insert();
+    u32 transfer_family = m_transfer_queue->family();
+    u32 compute_family = m_compute_queue->family();
+
+    RHI::BarrierBatch release(upload_cmd);
+    for (usize i = 0; i < models.size(); ++i) {
+        release
+            .release_buffer(*vertex_buffers[i], VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, transfer_family, compute_family)
+            .release_buffer(*index_buffers[i], VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, transfer_family, compute_family);
+
+        if (transform_buffers[i]) {
+            release.release_buffer(*transform_buffers[i], VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, transfer_family, compute_family);
+        }
+    }
+    release.insert();
 
     m_transfer_command->end(upload_cmd);
 
@@ -251,31 +355,74 @@ auto Application::load_scene() -> void
 
     // take ownership
 
-    RHI::BarrierBatch(blas_cmd)
-        .buffer(*sponza_vb, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR, m_device->transfer_index(), m_device->compute_index())
-        .buffer(*sponza_ib, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR, m_device->transfer_index(), m_device->compute_index())
-        .buffer(*teapot_vb, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR, m_device->transfer_index(), m_device->compute_index())
-        .buffer(*teapot_ib, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR, m_device->transfer_index(), m_device->compute_index())
-        .insert();
+    RHI::BarrierBatch acquire(blas_cmd);
+    for (usize i = 0; i < models.size(); ++i) {
+        acquire
+            .acquire_buffer(*vertex_buffers[i], VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR, transfer_family, compute_family)
+            .acquire_buffer(*index_buffers[i], VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR, transfer_family, compute_family);
 
-    RHI::BLAS::Input sponza_blas_input;
-    sponza_blas_input.add_geometry(*sponza_vb, sponza.mesh->vertices.size(), sizeof(Vertex), *sponza_ib, sponza.mesh->indices.size());
+        if (transform_buffers[i]) {
+            acquire.acquire_buffer(*transform_buffers[i], VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR, transfer_family, compute_family);
+        }
+    }
+    acquire.insert();
 
-    RHI::BLAS::Input teapot_blas_input;
-    teapot_blas_input.add_geometry(*teapot_vb, teapot.mesh->vertices.size(), sizeof(Vertex), *teapot_ib, teapot.mesh->indices.size());
+    u64 blas_input_size = 0;
 
-    auto raw_blases = as_builder.build_blas(blas_cmd, {
-        sponza_blas_input,
-        teapot_blas_input
-    });
+    // every (lod level, cluster) pair gets its own blas, a model's are contiguous starting at blas_offsets[i], level major
+
+    auto cluster_input = [&](usize i, std::span<const Submesh> submeshes) {
+        const auto& mesh = *models[i].mesh;
+        VkIndexType index_type = (mesh.index_type == IndexType::Uint16) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+
+        // one geometry per submesh over the shared buffers, only alpha tested parts keep any-hit
+        RHI::BLAS::Input input;
+        for (const auto& submesh : submeshes) {
+            input.add_geometry(
+                *vertex_buffers[i], mesh.vertex_count(), vertex_strides[i], vertex_formats[i],
+                *index_buffers[i], index_type, submesh.index_offset, submesh.index_count,
+                mesh.materials[submesh.material].opaque(), transform_buffers[i].get()
+            );
+        }
+
+        return input;
+    };
+
+    std::vector<RHI::BLAS::Input> blas_inputs;
+    std::vector<usize> blas_offsets(models.size());
+
+    for (usize i = 0; i < models.size(); ++i) {
+        const auto& mesh = *models[i].mesh;
+
+        blas_offsets[i] = blas_inputs.size();
+
+        for (usize level = 0; level < mesh.lods.size(); ++level) {
+            for (u32 cluster = 0; cluster < mesh.clusters.size(); ++cluster) {
+                blas_inputs.push_back(cluster_input(i, mesh.lod_submeshes(level, cluster)));
+            }
+        }
+
+        blas_input_size += vertex_buffers[i]->size();
+    }
+
+    auto raw_blases = as_builder.build_blas(blas_cmd, blas_inputs);
 
     m_compute_command->end(blas_cmd);
 
+    // wait for the uploads first so the timing below covers the build alone
+    m_transfer_queue->sync();
+
+    auto blas_start = std::chrono::steady_clock::now();
+
     std::vector<VkSemaphoreSubmitInfo> blas_signals;
     u64 blas_timeline = m_compute_queue->submit(blas_cmd, upload_signals, blas_signals);
 
     m_compute_queue->sync(blas_timeline);
 
+    std::chrono::duration<f64, std::milli> blas_time = std::chrono::steady_clock::now() - blas_start;
+    m_blas_ms = blas_time.count();
+    std::println("blas build: {} blases in {:.2f} ms, {:.1f} MB vertex input", blas_inputs.size(), blas_time.count(), static_cast<f64>(blas_input_size) / (1024.0 * 1024.0));
+
     auto compact_cmd = m_compute_command->begin();
 
     m_blases = as_builder.compact_blas(compact_cmd, raw_blases);
@@ -287,8 +434,183 @@ auto Application::load_scene() -> void
 
     auto tlas_cmd = m_compute_command->begin();
 
+    // the raygen camera sits at the origin with a 90 degree vertical fov, one unit at distance 1 covers half the image height
+    const f32 pixels_per_unit = static_cast<f32>(m_storage->height()) * 0.5f;
+
+    // one instance per cluster, each picks its level from its own bounds
+
+    std::vector<bool> referenced(m_blases.size(), false);
+
     RHI::TLAS::Input tlas_input;
-    for (const auto& blas : m_blases) {
+    for (usize i = 0; i < models.size(); ++i) {
+        const auto& mesh = *models[i].mesh;
+        glm::mat4 transform(1.0f);
+
+        std::vector<u32> level_counts(mesh.lods.size(), 0);
+
+        for (u32 cluster = 0; cluster < mesh.clusters.size(); ++cluster) {
+            const auto& bounds = mesh.clusters[cluster];
+
+            glm::vec3 center = glm::vec3(transform * glm::vec4(bounds.center(), 1.0f));
+            f32 distance = std::max(glm::length(center) - glm::length(bounds.extent()), 1e-3f);
+
+            u32 level = mesh.select_lod(distance, pixels_per_unit);
+            level_counts[level]++;
+
+            usize blas_index = blas_offsets[i] + level * mesh.clusters.size() + cluster;
+            referenced[blas_index] = true;
+
+            tlas_input.instances.push_back(VkAccelerationStructureInstanceKHR {
+                .transform = vkutils::glm_to_vkmatrix(transform),
+                .instanceCustomIndex = static_cast<u32>(i),
+                .mask = 0xFF,
+                .instanceShaderBindingTableRecordOffset = 0,
+                .flags = 0,
+                .accelerationStructureReference = m_blases[blas_index]->address()
+            });
+        }
+
+        std::string levels;
+        for (usize level = 0; level < level_counts.size(); ++level) {
+            levels += std::format("{}{}", level == 0 ? "" : "/", level_counts[level]);
+        }
+
+        std::println("{}: {} clusters, instances per lod {}", assets[i], mesh.clusters.size(), levels);
+    }
+
+    m_tlas = as_builder.build_tlas(tlas_cmd, tlas_input);
+
+    m_compute_command->end(tlas_cmd);
+    
+    // compaction first so the timing below covers the tlas build alone, like the blas timing above
+    m_compute_queue->sync(compact_timeline);
+
+    auto tlas_start = std::chrono::steady_clock::now();
+
+    std::vector<VkSemaphoreSubmitInfo> tlas_signals;
+    u64 tlas_timeline = m_compute_queue->submit(tlas_cmd, compact_signals, tlas_signals);
+
+    m_compute_queue->sync(tlas_timeline);
+
+    m_tlas_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - tlas_start).count();
+    std::println("tlas build: {} instances in {:.2f} ms", tlas_input.instances.size(), m_tlas_ms);
+
+    // levels are picked once at load, the ones no instance references would only hold memory
+
+    u64 selected_size = 0;
+    u64 lod0_size = 0;
+    u64 all_size = 0;
+
+    for (usize i = 0; i < models.size(); ++i) {
+        const auto& mesh = *models[i].mesh;
+
+        for (usize level = 0; level < mesh.lods.size(); ++level) {
+            for (u32 cluster = 0; cluster < mesh.clusters.size(); ++cluster) {
+                usize blas_index = blas_offsets[i] + level * mesh.clusters.size() + cluster;
+                u64 size = m_blases[blas_index]->buffer().size();
+
+                all_size += size;
+                if (level == 0) lod0_size += size;
+                if (referenced[blas_index]) selected_size += size;
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<RHI::BLAS>> kept;
+    for (usize b = 0; b < m_blases.size(); ++b) {
+        if (referenced[b]) kept.push_back(std::move(m_blases[b]));
+    }
+    m_blases = std::move(kept);
+
+    std::println("blas memory: {:.2f} MB in {} referenced blases, {:.2f} MB with lod 0 only, {:.2f} MB before unused levels were freed",
+        static_cast<f64>(selected_size) / (1024.0 * 1024.0), m_blases.size(),
+        static_cast<f64>(lod0_size) / (1024.0 * 1024.0),
+        static_cast<f64>(all_size) / (1024.0 * 1024.0)
+    );
+
+    std::chrono::duration<f64, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    std::println("scene loaded in {:.2f} ms", elapsed.count());
+
+    if (m_options.cluster_benchmark) {
+        std::vector<RHI::BLAS::Input> monolithic;
+        std::vector<RHI::BLAS::Input> clustered;
+
+        for (usize i = 0; i < models.size(); ++i) {
+            const auto& mesh = *models[i].mesh;
+
+            monolithic.push_back(cluster_input(i, mesh.lod_submeshes(0)));
+
+            for (u32 cluster = 0; cluster < mesh.clusters.size(); ++cluster) {
+                clustered.push_back(cluster_input(i, mesh.lod_submeshes(0, cluster)));
+            }
+        }
+
+        auto monolithic_stats = benchmark_blas(monolithic);
+        auto clustered_stats = benchmark_blas(clustered);
+
+        const f64 rays = static_cast<f64>(m_storage->width()) * static_cast<f64>(m_storage->height());
+
+        auto report = [&](std::string_view name, usize count, const BlasStats& stats) {
+            std::println(" - {}: {} blases, build {:.2f} ms, compacted {:.2f} MB, trace {:.3f} ms per frame ({:.1f} Mrays/s)",
+                name, count, stats.build_ms, static_cast<f64>(stats.compacted_size) / (1024.0 * 1024.0),
+                stats.frame_ms, stats.frame_ms > 0.0 ? rays / (stats.frame_ms * 1000.0) : 0.0
+            );
+        };
+
+        std::println("cluster benchmark (lod 0, {} frames at {}x{}):", s_BenchmarkFrames, m_storage->width(), m_storage->height());
+        report("monolithic", monolithic.size(), monolithic_stats);
+        report("clustered", clustered.size(), clustered_stats);
+    }
+
+    if (m_options.refit_benchmark) {
+        std::vector<RHI::BLAS::Input> updatable;
+
+        for (usize i = 0; i < models.size(); ++i) {
+            auto input = cluster_input(i, models[i].mesh->lod_submeshes(0));
+            input.allow_update = true;
+            updatable.push_back(std::move(input));
+        }
+
+        auto stats = benchmark_refit(updatable);
+
+        // the scene is static, so every refit sees the build pose, the cost of an update does not depend on it
+        std::println("refit benchmark (lod 0): {} blases, build {:.2f} ms, refit {:.2f} ms ({:.1f}x faster)",
+            updatable.size(), stats.build_ms, stats.refit_ms, stats.refit_ms > 0.0 ? stats.build_ms / stats.refit_ms : 0.0
+        );
+    }
+}
+
+auto Application::benchmark_blas(const std::vector<RHI::BLAS::Input>& inputs) -> BlasStats
+{
+    RHI::AccelerationStructureBuilder builder(m_device);
+
+    auto build_cmd = m_compute_command->begin();
+    auto blases = builder.build_blas(build_cmd, inputs);
+    m_compute_command->end(build_cmd);
+
+    auto build_start = std::chrono::steady_clock::now();
+
+    std::vector<VkSemaphoreSubmitInfo> build_signals;
+    m_compute_queue->sync(m_compute_queue->submit(build_cmd, {}, build_signals));
+
+    std::chrono::duration<f64, std::milli> build_time = std::chrono::steady_clock::now() - build_start;
+
+    auto compact_cmd = m_compute_command->begin();
+    auto compacted = builder.compact_blas(compact_cmd, blases);
+    m_compute_command->end(compact_cmd);
+
+    std::vector<VkSemaphoreSubmitInfo> compact_signals;
+    m_compute_queue->sync(m_compute_queue->submit(compact_cmd, {}, compact_signals));
+
+    BlasStats stats { .build_ms = build_time.count(), .compacted_size = 0, .frame_ms = 0.0 };
+    for (const auto& blas : compacted) {
+        stats.compacted_size += blas->buffer().size();
+    }
+
+    // the same camera over an identity instance per blas, so only the split into blases differs between runs
+
+    RHI::TLAS::Input tlas_input;
+    for (const auto& blas : compacted) {
         tlas_input.instances.push_back(VkAccelerationStructureInstanceKHR {
             .transform = vkutils::glm_to_vkmatrix(glm::mat4(1.0f)),
             .instanceCustomIndex = 0,
@@ -299,14 +621,89 @@ auto Application::load_scene() -> void
         });
     }
 
-    m_tlas = as_builder.build_tlas(tlas_cmd, tlas_input);
-
+    auto tlas_cmd = m_compute_command->begin();
+    auto tlas = builder.build_tlas(tlas_cmd, tlas_input);
     m_compute_command->end(tlas_cmd);
-    
+
     std::vector<VkSemaphoreSubmitInfo> tlas_signals;
-    u64 tlas_timeline = m_compute_queue->submit(tlas_cmd, compact_signals, tlas_signals);
+    m_compute_queue->sync(m_compute_queue->submit(tlas_cmd, {}, tlas_signals));
 
-    m_compute_queue->sync(tlas_timeline);
+    stats.frame_ms = time_frames(*tlas, s_BenchmarkFrames);
+
+    return stats;
+}
+
+auto Application::time_frames(const RHI::TLAS& tlas, u32 frames) -> f64
+{
+    std::array<u64, s_FramesInFlight> frame_values {};
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (u32 frame = 0; frame < frames; ++frame) {
+        usize frame_index = frame % s_FramesInFlight;
+        if (frame_values[frame_index] > 0) {
+            m_compute_queue->sync(frame_values[frame_index]);
+        }
+
+        auto cmd = m_compute_command->begin();
+
+        RHI::BarrierBatch(cmd)
+            .image(*m_storage,
+                VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                (frame == 0) ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+                VK_IMAGE_ASPECT_COLOR_BIT
+            )
+            .insert();
+
+        trace_rays(cmd, frame_index, tlas);
+
+        m_compute_command->end(cmd);
+
+        std::vector<VkSemaphoreSubmitInfo> signals;
+        frame_values[frame_index] = m_compute_queue->submit(cmd, {}, signals);
+    }
+
+    m_compute_queue->sync();
+
+    std::chrono::duration<f64, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / static_cast<f64>(std::max(frames, 1u));
+}
+
+auto Application::benchmark_refit(const std::vector<RHI::BLAS::Input>& inputs) -> RefitStats
+{
+    RHI::AccelerationStructureBuilder builder(m_device);
+
+    auto build_cmd = m_compute_command->begin();
+    auto blases = builder.build_blas(build_cmd, inputs);
+    m_compute_command->end(build_cmd);
+
+    auto build_start = std::chrono::steady_clock::now();
+
+    std::vector<VkSemaphoreSubmitInfo> build_signals;
+    m_compute_queue->sync(m_compute_queue->submit(build_cmd, {}, build_signals));
+
+    std::chrono::duration<f64, std::milli> build_time = std::chrono::steady_clock::now() - build_start;
+
+    RefitStats stats { .build_ms = build_time.count(), .refit_ms = std::numeric_limits<f64>::max() };
+
+    for (u32 step = 0; step < s_RefitSteps; ++step) {
+        auto refit_cmd = m_compute_command->begin();
+        for (usize i = 0; i < blases.size(); ++i) {
+            builder.refit_blas(refit_cmd, *blases[i], inputs[i]);
+        }
+        m_compute_command->end(refit_cmd);
+
+        auto refit_start = std::chrono::steady_clock::now();
+
+        std::vector<VkSemaphoreSubmitInfo> refit_signals;
+        m_compute_queue->sync(m_compute_queue->submit(refit_cmd, {}, refit_signals));
+
+        std::chrono::duration<f64, std::milli> refit_time = std::chrono::steady_clock::now() - refit_start;
+        stats.refit_ms = std::min(stats.refit_ms, refit_time.count());
+    }
+
+    return stats;
 }
 
 auto Application::build_rt_pipeline() -> void
@@ -315,6 +712,261 @@ auto Application::build_rt_pipeline() -> void
         .add_binding(0, VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR)
         .add_binding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR)
         .build();
+
+    // modules are only needed until the pipeline is created
+    RHI::Shader raygen_shader(m_device, "raygen.rgen.spv", VK_SHADER_STAGE_RAYGEN_BIT_KHR);
+    RHI::Shader miss_shader(m_device, "miss.rmiss.spv", VK_SHADER_STAGE_MISS_BIT_KHR);
+    RHI::Shader closesthit_shader(m_device, "closesthit.rchit.spv", VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR);
+
+    auto pipeline_start = std::chrono::steady_clock::now();
+
+    m_rt_pipeline = RHI::RayTracingPipeline::Builder(m_device)
+        .add_raygen(raygen_shader)
+        .add_miss(miss_shader)
+        .add_hit_group(&closesthit_shader)
+        .add_layout(*m_rt_descriptor_layout)
+        .max_recursion(1)
+        .cache(*m_pipeline_cache)
+        .build();
+
+    m_pipeline_ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - pipeline_start).count();
+
+    std::vector<std::unique_ptr<RHI::Buffer>> staging_buffers;
+
+    auto sbt_cmd = m_compute_command->begin();
+    m_sbt = std::make_unique<RHI::ShaderBindingTable>(m_device, sbt_cmd, *m_rt_pipeline, staging_buffers);
+    m_compute_command->end(sbt_cmd);
+
+    std::vector<VkSemaphoreSubmitInfo> sbt_signals;
+    m_compute_queue->sync(m_compute_queue->submit(sbt_cmd, {}, sbt_signals));
+
+    std::println("shader binding table: {} groups in {} bytes", m_rt_pipeline->group_count(), m_sbt->buffer().size());
+}
+
+auto Application::share_scene_with_graphics() -> void
+{
+    u32 compute_family = m_compute_queue->family();
+    u32 graphics_family = m_graphics_queue->family();
+
+    // separate submissions trace on the compute queue, and one family needs no transfer
+    if (!m_merge_submissions || compute_family == graphics_family) return;
+
+    auto release_cmd = m_compute_command->begin();
+
+    RHI::BarrierBatch release(release_cmd);
+    for (const auto& blas : m_blases) {
+        release.release_buffer(blas->buffer(), VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_COPY_BIT_KHR, VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR, compute_family, graphics_family);
+    }
+    release
+        .release_buffer(m_tlas->buffer(), VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR, compute_family, graphics_family)
+        .release_buffer(m_sbt->buffer(), VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, compute_family, graphics_family)
+        .insert();
+
+    m_compute_command->end(release_cmd);
+
+    std::vector<VkSemaphoreSubmitInfo> release_signals;
+    m_compute_queue->submit(release_cmd, {}, release_signals);
+
+    auto acquire_cmd = m_graphics_command->begin();
+
+    RHI::BarrierBatch acquire(acquire_cmd);
+    for (const auto& blas : m_blases) {
+        acquire.acquire_buffer(blas->buffer(), VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR, compute_family, graphics_family);
+    }
+    acquire
+        .acquire_buffer(m_tlas->buffer(), VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR, compute_family, graphics_family)
+        .acquire_buffer(m_sbt->buffer(), VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_BINDING_TABLE_READ_BIT_KHR, compute_family, graphics_family)
+        .insert();
+
+    m_graphics_command->end(acquire_cmd);
+
+    std::vector<VkSemaphoreSubmitInfo> acquire_signals;
+    m_graphics_queue->sync(m_graphics_queue->submit(acquire_cmd, { m_compute_queue->wait_info() }, acquire_signals));
+
+    std::println("handed {} blases, the tlas and the shader binding table to the graphics family", m_blases.size());
+}
+
+auto Application::trace_rays(VkCommandBuffer cmd, usize frame_index, const RHI::TLAS& tlas) -> void
+{
+    m_descriptor_allocators[frame_index]->reset();
+
+    VkDescriptorSet rt_set = m_descriptor_allocators[frame_index]->allocate(*m_rt_descriptor_layout);
+    RHI::DescriptorWriter(m_device)
+        .write_as(0, tlas)
+        .write_storage_image(1, *m_storage)
+        .update(rt_set);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, m_rt_pipeline->pipeline());
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, m_rt_pipeline->layout(), 0, 1, &rt_set, 0, nullptr);
+
+    m_sbt->trace(cmd, m_storage->width(), m_storage->height());
+}
+
+auto Application::run_headless() -> void
+{
+    build_rt_pipeline();
+    load_scene();
+
+    // everything stays on the compute queue, there is nothing to hand to a graphics queue for presentation
+    std::array<u64, s_FramesInFlight> frame_values {};
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (u32 frame = 0; frame < m_options.frames; ++frame) {
+        usize frame_index = frame % s_FramesInFlight;
+        if (frame_values[frame_index] > 0) {
+            m_compute_queue->sync(frame_values[frame_index]);
+        }
+
+        auto cmd = m_compute_command->begin();
+
+        RHI::BarrierBatch(cmd)
+            .image(*m_storage,
+                VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                (frame == 0) ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+                VK_IMAGE_ASPECT_COLOR_BIT
+            )
+            .insert();
+
+        trace_rays(cmd, frame_index, *m_tlas);
+
+        m_compute_command->end(cmd);
+
+        std::vector<VkSemaphoreSubmitInfo> signals;
+        frame_values[frame_index] = m_compute_queue->submit(cmd, {}, signals);
+
+        if (frame == 0) {
+            report_first_frame(*m_compute_queue, frame_values[frame_index]);
+        }
+
+        m_frame_count++;
+    }
+
+    m_compute_queue->sync();
+
+    std::chrono::duration<f64, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    f64 frame_ms = elapsed.count() / static_cast<f64>(std::max(m_options.frames, 1u));
+    std::println("headless: {} frames at {}x{} in {:.2f} ms, {:.3f} ms per frame",
+        m_options.frames, m_storage->width(), m_storage->height(), elapsed.count(), frame_ms
+    );
+
+    if (!m_options.json.empty() && write_timings(m_options.json, m_options.frames, frame_ms)) {
+        std::println("headless: wrote {}", m_options.json);
+    }
+
+    if (!m_options.output.empty()) {
+        auto cmd = m_compute_command->begin();
+        if (read_back(cmd)) {
+            std::println("headless: wrote {}", m_options.output);
+        }
+    }
+}
+
+auto Application::read_back(VkCommandBuffer cmd) -> bool
+{
+    u64 size = static_cast<u64>(m_storage->width()) * m_storage->height() * sizeof(glm::vec4);
+
+    RHI::Buffer readback(m_device, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_AUTO_PREFER_HOST, VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT);
+
+    RHI::BarrierBatch(cmd)
+        .image(*m_storage,
+            VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT,
+            (m_frame_count == 0) ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_IMAGE_ASPECT_COLOR_BIT
+        )
+        .insert();
+
+    VkBufferImageCopy region {
+        .bufferOffset = 0,
+        .bufferRowLength = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mipLevel = 0,
+            .baseArrayLayer = 0,
+            .layerCount = 1
+        },
+        .imageOffset = { 0, 0, 0 },
+        .imageExtent = m_storage->extent()
+    };
+
+    vkCmdCopyImageToBuffer(cmd, m_storage->image(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback.buffer(), 1, &region);
+
+    RHI::BarrierBatch(cmd)
+        .buffer(readback, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_HOST_BIT, VK_ACCESS_2_HOST_READ_BIT)
+        .image(*m_storage,
+            VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT,
+            VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL,
+            VK_IMAGE_ASPECT_COLOR_BIT
+        )
+        .insert();
+
+    m_compute_command->end(cmd);
+
+    std::vector<VkSemaphoreSubmitInfo> signals;
+    m_compute_queue->sync(m_compute_queue->submit(cmd, {}, signals));
+
+    const auto* pixels = reinterpret_cast<const glm::vec4*>(readback.map());
+    bool written = CPU::ImageWriter::write_pfm(m_options.output, m_storage->width(), m_storage->height(),
+        std::span<const glm::vec4>(pixels, static_cast<usize>(m_storage->width()) * m_storage->height())
+    );
+    readback.unmap();
+
+    return written;
+}
+
+auto Application::report_first_frame(RHI::Queue& queue, u64 value) -> void
+{
+    queue.sync(value);
+
+    std::chrono::duration<f64, std::milli> elapsed = std::chrono::steady_clock::now() - m_start;
+    std::println("first frame after {:.2f} ms, rt pipeline created in {:.2f} ms with a {} pipeline cache",
+        elapsed.count(), m_pipeline_ms, m_pipeline_cache->warm() ? "warm" : "cold"
+    );
+}
+
+auto Application::write_timings(const std::filesystem::path& path, u32 frames, f64 frame_ms) const -> bool
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) {
+        std::println(std::cerr, "Application: failed to open {}", path.string());
+        return false;
+    }
+
+    // the device name is the only free text, escape what json needs
+    VkPhysicalDeviceProperties props = m_device->props();
+
+    std::string device = "\"";
+    for (char c : std::string_view(props.deviceName)) {
+        if (c == '"' || c == '\\') device += '\\';
+        device += c;
+    }
+    device += '"';
+
+    f64 rays = static_cast<f64>(m_storage->width()) * static_cast<f64>(m_storage->height());
+
+    file << "{\n";
+    file << "  \"gpu\": {\n";
+    file << std::format("    \"device\": {},\n", device);
+    file << std::format("    \"width\": {},\n", m_storage->width());
+    file << std::format("    \"height\": {},\n", m_storage->height());
+    file << std::format("    \"blas_build_ms\": {:.3f},\n", m_blas_ms);
+    file << std::format("    \"tlas_build_ms\": {:.3f},\n", m_tlas_ms);
+    file << std::format("    \"frames\": {},\n", frames);
+    file << std::format("    \"frame_ms\": {:.3f},\n", frame_ms);
+    file << std::format("    \"mrays\": {:.3f}\n", frame_ms > 0.0 ? rays / (frame_ms * 1000.0) : 0.0);
+    file << "  }\n";
+    file << "}\n";
+
+    if (!file.good()) {
+        std::println(std::cerr, "Application: failed to write {}", path.string());
+        return false;
+    }
+
+    return true;
 }
 
 auto Application::dispatch_events(const Event& event) -> void
@@ -12,25 +12,101 @@
 #include "rhi/image.hpp"
 
 #include "rhi/descriptor.hpp"
+#include "rhi/acceleration_structure.hpp"
+#include "rhi/pipeline.hpp"
+#include "rhi/pipeline_cache.hpp"
+
+struct ApplicationOptions
+{
+    u32 width { 1280 };
+    u32 height { 720 };
+
+    // no window, surface or swapchain: frames render into the storage image and the last one is read back to output
+    bool headless { false };
+    u32 frames { 1 };
+    std::string output { "frame.pfm" };
+    // device, build and frame timings of a headless run as JSON, rtx_bench --gpu embeds it in its report
+    std::string json;
+
+    // physical device index or name substring, RTX_DEVICE is used when empty
+    std::string device;
+
+    // trace on the compute queue and hand the image to the graphics queue every frame
+    bool async_compute { true };
+
+    // start without the pipeline cache on disk, it is still written back on exit
+    bool cold_pipeline_cache { false };
+
+    // rebuilds lod 0 monolithic and clustered after loading and prints build time, memory and traced frame time
+    bool cluster_benchmark { false };
+
+    // rebuilds lod 0 with allow_update after loading, refits it a few times and prints build against refit time
+    bool refit_benchmark { false };
+};
 
 class Application
 {
 public:
-    Application();
+    Application(const ApplicationOptions& options = {});
     ~Application();
 
     auto run() -> void;
 
+private:
+    struct BlasStats
+    {
+        f64 build_ms;
+        u64 compacted_size;
+        // per traced frame over a tlas of just these blases
+        f64 frame_ms;
+    };
+
+    struct RefitStats
+    {
+        f64 build_ms;
+        f64 refit_ms;
+    };
+
 private:
     auto load_scene() -> void;
     auto build_rt_pipeline() -> void;
+    // merged frames trace on the graphics queue, hands it the structures and table built on the compute queue
+    auto share_scene_with_graphics() -> void;
+
+    // binds the pipeline and this frame's descriptors and traces into the storage image, which must be in GENERAL layout
+    auto trace_rays(VkCommandBuffer cmd, usize frame_index, const RHI::TLAS& tlas) -> void;
+    // average time of traced frames on the compute queue, blocks until they are done
+    auto time_frames(const RHI::TLAS& tlas, u32 frames) -> f64;
+
+    auto run_headless() -> void;
+    // copies the storage image to the host and writes it as a float image, blocks until the copy is done
+    auto read_back(VkCommandBuffer cmd) -> bool;
+
+    auto benchmark_blas(const std::vector<RHI::BLAS::Input>& inputs) -> BlasStats;
+    // best of a few refits of all inputs together, each in its own submission
+    auto benchmark_refit(const std::vector<RHI::BLAS::Input>& inputs) -> RefitStats;
 
     auto dispatch_events(const Event& event) -> void;
 
+    // blocks on the first frame's submission once, so the time covers the gpu work too
+    auto report_first_frame(RHI::Queue& queue, u64 value) -> void;
+    auto write_timings(const std::filesystem::path& path, u32 frames, f64 frame_ms) const -> bool;
+
 private:
     inline static constexpr usize s_FramesInFlight { 3 };
+    inline static constexpr u32 s_RefitSteps { 5 };
+    inline static constexpr u32 s_BenchmarkFrames { 32 };
 
 private:
+    ApplicationOptions m_options;
+
+    std::chrono::steady_clock::time_point m_start;
+    f64 m_pipeline_ms { 0.0 };
+    f64 m_blas_ms { 0.0 };
+    f64 m_tlas_ms { 0.0 };
+
+    bool m_merge_submissions { false };
+
     bool m_running { true };
     bool m_minimized { false };
 
@@ -41,6 +117,9 @@ private:
 
     std::unique_ptr<RHI::Swapchain> m_swapchain;
 
+    // declared after the device so it is saved and destroyed first
+    std::unique_ptr<RHI::PipelineCache> m_pipeline_cache;
+
     std::unique_ptr<RHI::Command> m_graphics_command;
     std::unique_ptr<RHI::Command> m_compute_command;
     std::unique_ptr<RHI::Command> m_transfer_command;
@@ -57,6 +136,8 @@ private:
     std::unique_ptr<RHI::TLAS> m_tlas;
 
     std::unique_ptr<RHI::DescriptorLayout> m_rt_descriptor_layout;
+    std::unique_ptr<RHI::RayTracingPipeline> m_rt_pipeline;
+    std::unique_ptr<RHI::ShaderBindingTable> m_sbt;
 
     u64 m_frame_count { 0 };
 };
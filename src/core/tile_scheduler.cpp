@@ -0,0 +1,266 @@
+#include "tile_scheduler.hpp"
+
+namespace {
+
+    // one per worker, padded so owners and thieves locking neighbouring queues do not share a line
+    struct alignas(64) WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<u32> tiles;
+    };
+
+    // spreads the low 16 bits of v to the even bits
+    auto spread_bits(u32 v) -> u32
+    {
+        v &= 0x0000ffff;
+        v = (v | (v << 8)) & 0x00ff00ff;
+        v = (v | (v << 4)) & 0x0f0f0f0f;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        return v;
+    }
+
+    auto morton_index(u32 x, u32 y) -> u64
+    {
+        return spread_bits(x) | (spread_bits(y) << 1);
+    }
+
+    // distance along the hilbert curve filling an n x n square, n a power of two
+    auto hilbert_index(u32 n, u32 x, u32 y) -> u64
+    {
+        u64 d = 0;
+        for (u32 s = n / 2; s > 0; s /= 2) {
+            u32 rx = (x & s) > 0 ? 1 : 0;
+            u32 ry = (y & s) > 0 ? 1 : 0;
+            d += static_cast<u64>(s) * s * ((3 * rx) ^ ry);
+
+            if (ry == 0) {
+                if (rx == 1) {
+                    x = n - 1 - x;
+                    y = n - 1 - y;
+                }
+                std::swap(x, y);
+            }
+        }
+        return d;
+    }
+
+}
+
+auto TileStats::average_utilization() const -> f64
+{
+    if (workers.empty()) return 0.0;
+
+    f64 sum = 0.0;
+    for (u32 i = 0; i < workers.size(); ++i) {
+        sum += utilization(i);
+    }
+    return sum / static_cast<f64>(workers.size());
+}
+
+auto TileStats::min_utilization() const -> f64
+{
+    if (workers.empty()) return 0.0;
+
+    f64 lowest = std::numeric_limits<f64>::max();
+    for (u32 i = 0; i < workers.size(); ++i) {
+        lowest = std::min(lowest, utilization(i));
+    }
+    return lowest;
+}
+
+auto TileStats::stolen() const -> u32
+{
+    u32 count = 0;
+    for (const auto& worker : workers) {
+        count += worker.stolen;
+    }
+    return count;
+}
+
+TileScheduler::TileScheduler(const TileSchedulerOptions& options)
+    : m_options(options)
+{
+    m_options.tile_size = std::max(m_options.tile_size, 1u);
+    if (m_options.thread_count == 0) {
+        m_options.thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    m_workers.reserve(m_options.thread_count);
+    for (u32 t = 0; t < m_options.thread_count; ++t) {
+        m_workers.emplace_back([this, t] { worker_loop(t); });
+    }
+}
+
+TileScheduler::~TileScheduler()
+{
+    {
+        std::scoped_lock lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_wake.notify_all();
+}
+
+auto TileScheduler::worker_loop(u32 worker) -> void
+{
+    u64 generation = 0;
+
+    while (true) {
+        std::unique_lock lock(m_mutex);
+        m_wake.wait(lock, [&] { return m_stopping || m_generation != generation; });
+        if (m_stopping) return;
+
+        generation = m_generation;
+        lock.unlock();
+
+        m_work(worker);
+
+        lock.lock();
+        if (--m_active == 0) {
+            m_done.notify_one();
+        }
+    }
+}
+
+auto TileScheduler::run(u32 width, u32 height, const TileFn& fn) -> void
+{
+    u32 tile_size = m_options.tile_size;
+    u32 tiles_x = (width + tile_size - 1) / tile_size;
+    u32 tiles_y = (height + tile_size - 1) / tile_size;
+
+    std::vector<u32> order = tile_order(tiles_x, tiles_y, m_options.order);
+    u32 tile_count = static_cast<u32>(order.size());
+    u32 thread_count = m_options.thread_count;
+
+    // contiguous runs of the curve keep each worker's tiles next to each other until stealing starts
+    std::vector<WorkQueue> queues(thread_count);
+    for (u32 t = 0; t < thread_count; ++t) {
+        u32 first = static_cast<u32>(static_cast<u64>(tile_count) * t / thread_count);
+        u32 last = static_cast<u32>(static_cast<u64>(tile_count) * (t + 1) / thread_count);
+        queues[t].tiles.assign(order.begin() + first, order.begin() + last);
+    }
+
+    m_stats.workers.assign(thread_count, TileWorkerStats {});
+
+    auto execute = [&](u32 worker, u32 index) {
+        Tile tile {
+            .x0 = (index % tiles_x) * tile_size,
+            .y0 = (index / tiles_x) * tile_size,
+            .x1 = std::min((index % tiles_x) * tile_size + tile_size, width),
+            .y1 = std::min((index / tiles_x) * tile_size + tile_size, height),
+            .index = index
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        fn(tile, worker);
+        std::chrono::duration<f64, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        auto& stats = m_stats.workers[worker];
+        stats.tiles++;
+        stats.busy_ms += elapsed.count();
+    };
+
+    auto pop = [&](u32 worker) -> std::optional<u32> {
+        auto& queue = queues[worker];
+        std::scoped_lock lock(queue.mutex);
+        if (queue.tiles.empty()) return std::nullopt;
+
+        u32 index = queue.tiles.front();
+        queue.tiles.pop_front();
+        return index;
+    };
+
+    // takes the back half of the first non empty victim, the end furthest from where its owner is working
+    auto steal = [&](u32 worker, u32 seed) -> std::optional<u32> {
+        std::vector<u32> loot;
+
+        for (u32 i = 0; i + 1 < thread_count && loot.empty(); ++i) {
+            auto& victim = queues[(worker + 1 + (seed + i) % (thread_count - 1)) % thread_count];
+
+            std::scoped_lock lock(victim.mutex);
+            usize take = (victim.tiles.size() + 1) / 2;
+            loot.assign(victim.tiles.end() - static_cast<std::ptrdiff_t>(take), victim.tiles.end());
+            victim.tiles.erase(victim.tiles.end() - static_cast<std::ptrdiff_t>(take), victim.tiles.end());
+        }
+
+        if (loot.empty()) return std::nullopt;
+
+        m_stats.workers[worker].stolen += static_cast<u32>(loot.size());
+
+        if (loot.size() > 1) {
+            auto& queue = queues[worker];
+            std::scoped_lock lock(queue.mutex);
+            queue.tiles.insert(queue.tiles.end(), loot.begin() + 1, loot.end());
+        }
+
+        return loot.front();
+    };
+
+    m_work = [&](u32 worker) {
+        // victims are probed from a per worker offset so thieves do not all hit the same queue
+        std::minstd_rand rng(worker + 1);
+
+        // tiles only ever move between queues, once every queue is empty the last ones are running elsewhere
+        // and this worker goes back to sleep instead of spinning until they finish
+        while (true) {
+            if (auto index = pop(worker)) {
+                execute(worker, *index);
+            } else if (auto stolen = steal(worker, static_cast<u32>(rng()))) {
+                execute(worker, *stolen);
+            } else {
+                break;
+            }
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+
+    {
+        std::unique_lock lock(m_mutex);
+        m_active = thread_count;
+        m_generation++;
+        m_wake.notify_all();
+
+        m_done.wait(lock, [&] { return m_active == 0; });
+    }
+
+    std::chrono::duration<f64, std::milli> wall = std::chrono::steady_clock::now() - start;
+    m_stats.wall_ms = wall.count();
+
+    m_work = nullptr;
+}
+
+auto TileScheduler::tile_order(u32 tiles_x, u32 tiles_y, TileOrder order) -> std::vector<u32>
+{
+    std::vector<u32> tiles(static_cast<usize>(tiles_x) * tiles_y);
+    std::iota(tiles.begin(), tiles.end(), 0u);
+
+    if (order == TileOrder::Scanline || tiles.empty()) {
+        return tiles;
+    }
+
+    // the curves are defined on a power of two square, tiles outside the image are simply absent
+    u32 side = std::bit_ceil(std::max(tiles_x, tiles_y));
+
+    std::vector<u64> keys(tiles.size());
+    for (u32 index : tiles) {
+        u32 x = index % tiles_x;
+        u32 y = index / tiles_x;
+        keys[index] = order == TileOrder::Morton ? morton_index(x, y) : hilbert_index(side, x, y);
+    }
+
+    std::ranges::sort(tiles, {}, [&](u32 index) { return keys[index]; });
+
+    return tiles;
+}
+
+auto TileScheduler::name(TileOrder order) -> std::string_view
+{
+    switch (order) {
+        case TileOrder::Scanline: return "scanline";
+        case TileOrder::Morton: return "morton";
+        case TileOrder::Hilbert: return "hilbert";
+    }
+    return "unknown";
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+// order tiles are laid out in before they are dealt to the workers, neighbouring tiles along a curve share cache lines
+// of the image and nodes of the BVH
+enum class TileOrder : u32
+{
+    Scanline,
+    Morton,
+    Hilbert
+};
+
+struct Tile
+{
+    u32 x0;
+    u32 y0;
+    // exclusive, clamped to the image
+    u32 x1;
+    u32 y1;
+    // row major tile id
+    u32 index;
+
+    [[nodiscard]] auto width() const -> u32 { return x1 - x0; }
+    [[nodiscard]] auto height() const -> u32 { return y1 - y0; }
+    [[nodiscard]] auto area() const -> u32 { return width() * height(); }
+};
+
+struct TileSchedulerOptions
+{
+    u32 tile_size { 16 };
+    TileOrder order { TileOrder::Hilbert };
+
+    // worker threads, 0 uses every hardware thread
+    u32 thread_count { 0 };
+};
+
+struct TileWorkerStats
+{
+    u32 tiles { 0 };
+    // tiles taken from other workers' deques
+    u32 stolen { 0 };
+    // time spent inside the tile callback
+    f64 busy_ms { 0.0 };
+};
+
+struct TileStats
+{
+    // from waking the workers until the last tile is done
+    f64 wall_ms { 0.0 };
+    std::vector<TileWorkerStats> workers;
+
+    // busy time over wall time for one worker, 1 means it never waited
+    [[nodiscard]] auto utilization(u32 worker) const -> f64 { return wall_ms > 0.0 ? workers[worker].busy_ms / wall_ms : 0.0; }
+    [[nodiscard]] auto average_utilization() const -> f64;
+    [[nodiscard]] auto min_utilization() const -> f64;
+    [[nodiscard]] auto stolen() const -> u32;
+};
+
+// splits an image into tiles and runs them on a pool of workers. every worker starts with a contiguous run of the
+// tile curve in its own deque and takes from the front, a worker that runs dry steals the back half of another
+// deque, so cheap sky tiles and expensive geometry tiles even out without a static split. the workers are started
+// once and sleep between runs
+class TileScheduler
+{
+public:
+    using TileFn = std::function<void(const Tile& tile, u32 worker)>;
+
+public:
+    TileScheduler(const TileSchedulerOptions& options = {});
+    ~TileScheduler();
+
+    TileScheduler(const TileScheduler&) = delete;
+    TileScheduler& operator=(const TileScheduler&) = delete;
+
+    // returns once every tile of the width x height image has run, worker is in [0, thread_count)
+    auto run(u32 width, u32 height, const TileFn& fn) -> void;
+
+    [[nodiscard]] auto options() const -> const TileSchedulerOptions& { return m_options; }
+    [[nodiscard]] auto thread_count() const -> u32 { return m_options.thread_count; }
+    // of the last run
+    [[nodiscard]] auto stats() const -> const TileStats& { return m_stats; }
+
+    // row major tile ids of a tiles_x x tiles_y grid in curve order
+    static auto tile_order(u32 tiles_x, u32 tiles_y, TileOrder order) -> std::vector<u32>;
+    static auto name(TileOrder order) -> std::string_view;
+
+private:
+    auto worker_loop(u32 worker) -> void;
+
+private:
+    TileSchedulerOptions m_options;
+    TileStats m_stats;
+
+    std::mutex m_mutex;
+    // workers wait here for the next run, run() waits on m_done until all of them finished it
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    u64 m_generation { 0 };
+    u32 m_active { 0 };
+    bool m_stopping { false };
+    // the current run's loop for one worker, only valid while run() is waiting
+    std::function<void(u32 worker)> m_work;
+
+    // last, so the workers are joined before the state they wait on goes away
+    std::vector<std::jthread> m_workers;
+};
@@ -0,0 +1,37 @@
+#include "image_writer.hpp"
+
+namespace CPU {
+
+    auto ImageWriter::write_pfm(const std::filesystem::path& path, u32 width, u32 height, std::span<const glm::vec4> pixels) -> bool
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::println(std::cerr, "ImageWriter: failed to open {}", path.string());
+            return false;
+        }
+
+        // a negative scale marks little endian data
+        file << std::format("PF\n{} {}\n-1.0\n", width, height);
+
+        // pfm stores rows bottom to top
+        std::vector<f32> row(static_cast<usize>(width) * 3);
+        for (u32 y = height; y-- > 0;) {
+            for (u32 x = 0; x < width; ++x) {
+                const auto& pixel = pixels[static_cast<usize>(y) * width + x];
+                row[x * 3 + 0] = pixel.x;
+                row[x * 3 + 1] = pixel.y;
+                row[x * 3 + 2] = pixel.z;
+            }
+
+            file.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size() * sizeof(f32)));
+        }
+
+        if (!file.good()) {
+            std::println(std::cerr, "ImageWriter: failed to write {}", path.string());
+            return false;
+        }
+
+        return true;
+    }
+
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace CPU {
+
+    class ImageWriter
+    {
+    public:
+        // portable float map, keeps the full rgba32f range for diffing against gpu captures (alpha is dropped)
+        static auto write_pfm(const std::filesystem::path& path, u32 width, u32 height, std::span<const glm::vec4> pixels) -> bool;
+    };
+
+}
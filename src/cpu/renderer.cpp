@@ -0,0 +1,79 @@
+#include "renderer.hpp"
+
+namespace CPU {
+
+    Renderer::Renderer(u32 width, u32 height, const TileSchedulerOptions& schedule)
+        : m_width(width), m_height(height), m_scheduler(schedule)
+    {
+        m_image.resize(static_cast<usize>(width) * height);
+
+        usize tile_area = static_cast<usize>(m_scheduler.options().tile_size) * m_scheduler.options().tile_size;
+
+        m_scratch.resize(m_scheduler.thread_count());
+        for (auto& scratch : m_scratch) {
+            scratch.rays.resize(tile_area);
+            scratch.hits.resize(tile_area);
+        }
+    }
+
+    auto Renderer::render(const Scene& scene) -> void
+    {
+        // sky tiles finish far sooner than geometry tiles, idle workers steal what is left
+        m_scheduler.run(m_width, m_height, [&](const Tile& tile, u32 worker) {
+            render_tile(scene, tile, m_scratch[worker]);
+        });
+    }
+
+    auto Renderer::render_tile(const Scene& scene, const Tile& tile, TileScratch& scratch) -> void
+    {
+        // a tile of primary rays is coherent enough to be traced in packets
+        usize count = 0;
+        for (u32 y = tile.y0; y < tile.y1; ++y) {
+            for (u32 x = tile.x0; x < tile.x1; ++x) {
+                scratch.rays[count++] = primary_ray(x, y, m_width, m_height);
+            }
+        }
+
+        auto rays = std::span(scratch.rays).first(count);
+        auto hits = std::span(scratch.hits).first(count);
+        std::ranges::fill(hits, Hit {});
+
+        for (const auto& mesh : scene.meshes) {
+            Traversal::intersect_packets(mesh, rays, hits);
+        }
+
+        usize i = 0;
+        for (u32 y = tile.y0; y < tile.y1; ++y) {
+            for (u32 x = tile.x0; x < tile.x1; ++x) {
+                m_image[static_cast<usize>(y) * m_width + x] = glm::vec4(shade(hits[i++]), 1.0f);
+            }
+        }
+    }
+
+    // raygen.rgen with its identity view and projection
+    auto Renderer::primary_ray(u32 x, u32 y, u32 width, u32 height) -> Ray
+    {
+        glm::vec2 pixel_center = glm::vec2(static_cast<f32>(x), static_cast<f32>(y)) + glm::vec2(0.5f);
+        glm::vec2 in_uv = pixel_center / glm::vec2(static_cast<f32>(width), static_cast<f32>(height));
+        glm::vec2 d = in_uv * 2.0f - 1.0f;
+
+        return Ray {
+            .origin = glm::vec3(0.0f),
+            .direction = glm::normalize(glm::vec3(d.x, d.y, 1.0f)),
+            .tmin = 0.001f,
+            .tmax = 10000.0f
+        };
+    }
+
+    auto Renderer::shade(const Hit& hit) -> glm::vec3
+    {
+        // closesthit.rchit
+        if (hit.valid()) {
+            return glm::vec3(1.0f - hit.u - hit.v, hit.u, hit.v);
+        }
+
+        // miss.rmiss
+        return glm::vec3(0.1f);
+    }
+
+}
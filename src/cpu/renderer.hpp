@@ -0,0 +1,55 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "core/tile_scheduler.hpp"
+#include "scene/traversal.hpp"
+
+namespace CPU {
+
+    struct Scene
+    {
+        std::vector<Bvh> meshes;
+    };
+
+    // software stand-in for the ray tracing pipeline, shades like raygen.rgen, closesthit.rchit and miss.rmiss
+    class Renderer
+    {
+    public:
+        Renderer(u32 width, u32 height, const TileSchedulerOptions& schedule = {});
+
+        auto render(const Scene& scene) -> void;
+
+        [[nodiscard]] auto width() const -> u32 { return m_width; }
+        [[nodiscard]] auto height() const -> u32 { return m_height; }
+        [[nodiscard]] auto thread_count() const -> u32 { return m_scheduler.thread_count(); }
+        [[nodiscard]] auto scheduler() const -> const TileScheduler& { return m_scheduler; }
+
+        // rgba32f, rows top to bottom like the storage image
+        [[nodiscard]] auto image() const -> std::span<const glm::vec4> { return m_image; }
+
+    private:
+        // per worker ray and hit storage, sized for one tile
+        struct TileScratch
+        {
+            std::vector<Ray> rays;
+            std::vector<Hit> hits;
+        };
+
+    private:
+        auto render_tile(const Scene& scene, const Tile& tile, TileScratch& scratch) -> void;
+
+        static auto primary_ray(u32 x, u32 y, u32 width, u32 height) -> Ray;
+        static auto shade(const Hit& hit) -> glm::vec3;
+
+    private:
+        u32 m_width { 0 };
+        u32 m_height { 0 };
+
+        TileScheduler m_scheduler;
+        std::vector<TileScratch> m_scratch;
+
+        std::vector<glm::vec4> m_image;
+    };
+
+}
@@ -1,8 +1,222 @@
 #include "core/application.hpp"
 
-auto main() -> i32
+#include "cpu/renderer.hpp"
+#include "cpu/image_writer.hpp"
+
+#include "scene/loader.hpp"
+
+namespace {
+
+    struct CpuOptions
+    {
+        u32 width { 1280 };
+        u32 height { 720 };
+        u32 threads { 0 };
+        u32 frames { 1 };
+        u32 tile_size { 16 };
+        TileOrder order { TileOrder::Hilbert };
+        std::string output { "cpu.pfm" };
+    };
+
+    auto parse_u32(std::string_view text, u32& value) -> bool
+    {
+        auto [next, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return ec == std::errc() && next == text.data() + text.size();
+    }
+
+    auto parse_order(std::string_view text, TileOrder& order) -> bool
+    {
+        for (TileOrder candidate : { TileOrder::Scanline, TileOrder::Morton, TileOrder::Hilbert }) {
+            if (text == TileScheduler::name(candidate)) {
+                order = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    auto has_flag(std::span<char*> args, std::string_view flag) -> bool
+    {
+        return std::ranges::any_of(args, [flag](const char* arg) { return std::string_view(arg) == flag; });
+    }
+
+    auto parse_cpu_options(std::span<char*> args, CpuOptions& options) -> bool
+    {
+        for (usize i = 0; i < args.size(); ++i) {
+            std::string_view arg = args[i];
+
+            if (arg == "--cpu") continue;
+
+            if (i + 1 >= args.size()) {
+                std::println(std::cerr, "missing value for {}", arg);
+                return false;
+            }
+
+            std::string_view value = args[++i];
+
+            bool valid = true;
+            if (arg == "--width") valid = parse_u32(value, options.width);
+            else if (arg == "--height") valid = parse_u32(value, options.height);
+            else if (arg == "--threads") valid = parse_u32(value, options.threads);
+            else if (arg == "--frames") valid = parse_u32(value, options.frames);
+            else if (arg == "--tile") valid = parse_u32(value, options.tile_size);
+            else if (arg == "--order") valid = parse_order(value, options.order);
+            else if (arg == "--output") options.output = value;
+            else {
+                std::println(std::cerr, "unknown option {}", arg);
+                return false;
+            }
+
+            if (!valid) {
+                std::println(std::cerr, "invalid value {} for {}", value, arg);
+                return false;
+            }
+        }
+
+        return options.width > 0 && options.height > 0 && options.frames > 0 && options.tile_size > 0;
+    }
+
+    auto parse_app_options(std::span<char*> args, ApplicationOptions& options) -> bool
+    {
+        for (usize i = 0; i < args.size(); ++i) {
+            std::string_view arg = args[i];
+
+            if (arg == "--headless") {
+                options.headless = true;
+                continue;
+            }
+
+            if (arg == "--no-async-compute") {
+                options.async_compute = false;
+                continue;
+            }
+
+            if (arg == "--cold-pipeline-cache") {
+                options.cold_pipeline_cache = true;
+                continue;
+            }
+
+            if (arg == "--cluster-benchmark") {
+                options.cluster_benchmark = true;
+                continue;
+            }
+
+            if (arg == "--refit-benchmark") {
+                options.refit_benchmark = true;
+                continue;
+            }
+
+            if (i + 1 >= args.size()) {
+                std::println(std::cerr, "missing value for {}", arg);
+                return false;
+            }
+
+            std::string_view value = args[++i];
+
+            bool valid = true;
+            if (arg == "--width") valid = parse_u32(value, options.width);
+            else if (arg == "--height") valid = parse_u32(value, options.height);
+            else if (arg == "--frames") valid = parse_u32(value, options.frames);
+            else if (arg == "--output") options.output = value;
+            else if (arg == "--json") options.json = value;
+            else if (arg == "--device") options.device = value;
+            else {
+                std::println(std::cerr, "unknown option {}", arg);
+                return false;
+            }
+
+            if (!valid) {
+                std::println(std::cerr, "invalid value {} for {}", value, arg);
+                return false;
+            }
+        }
+
+        return options.width > 0 && options.height > 0 && options.frames > 0;
+    }
+
+    // renders the default scene on the host, no window or Vulkan device involved
+    auto run_cpu(const CpuOptions& options) -> i32
+    {
+        const std::vector<std::string> assets {
+            "assets/sponza/sponza.obj",
+            "assets/teapot.obj"
+        };
+
+        auto start = std::chrono::steady_clock::now();
+
+        LoadBatch batch(assets);
+
+        CPU::Scene scene;
+        scene.meshes.resize(assets.size());
+        while (auto loaded = batch.next()) {
+            scene.meshes[loaded->first] = Bvh::build(*loaded->second.mesh);
+        }
+
+        std::chrono::duration<f64, std::milli> load_time = std::chrono::steady_clock::now() - start;
+        std::println("cpu scene ready in {:.2f} ms", load_time.count());
+
+        CPU::Renderer renderer(options.width, options.height, TileSchedulerOptions {
+            .tile_size = options.tile_size,
+            .order = options.order,
+            .thread_count = options.threads
+        });
+
+        f64 best_ms = std::numeric_limits<f64>::max();
+        for (u32 frame = 0; frame < options.frames; ++frame) {
+            auto frame_start = std::chrono::steady_clock::now();
+            renderer.render(scene);
+            std::chrono::duration<f64, std::milli> frame_time = std::chrono::steady_clock::now() - frame_start;
+
+            best_ms = std::min(best_ms, frame_time.count());
+        }
+
+        f64 rays = static_cast<f64>(options.width) * options.height;
+        std::println("cpu render: {}x{} on {} threads, best of {} frames {:.2f} ms, {:.2f} Mrays/s",
+            options.width, options.height, renderer.thread_count(), options.frames, best_ms, rays / (best_ms * 1000.0)
+        );
+
+        // of the last frame, a low minimum means some worker sat idle waiting for the others
+        const auto& stats = renderer.scheduler().stats();
+        std::println("tiles: {}px {}, utilization avg {:.1f}% min {:.1f}%, {} tiles stolen",
+            options.tile_size, TileScheduler::name(options.order), stats.average_utilization() * 100.0, stats.min_utilization() * 100.0, stats.stolen()
+        );
+        for (u32 worker = 0; worker < stats.workers.size(); ++worker) {
+            std::println(" - worker {:>3}: {:>5} tiles, {:>5} stolen, {:.1f}% busy",
+                worker, stats.workers[worker].tiles, stats.workers[worker].stolen, stats.utilization(worker) * 100.0
+            );
+        }
+
+        if (!options.output.empty() && !CPU::ImageWriter::write_pfm(options.output, renderer.width(), renderer.height(), renderer.image())) {
+            return 1;
+        }
+
+        return 0;
+    }
+
+}
+
+auto main(i32 argc, char** argv) -> i32
 {
-    Application* app = new Application();
+    std::span<char*> args(argv + 1, static_cast<usize>(std::max(argc - 1, 0)));
+
+    if (has_flag(args, "--cpu")) {
+        CpuOptions options;
+        if (!parse_cpu_options(args, options)) {
+            std::println(std::cerr, "usage: RTX --cpu [--width N] [--height N] [--threads N] [--frames N] [--tile N] [--order scanline|morton|hilbert] [--output file.pfm]");
+            return 1;
+        }
+
+        return run_cpu(options);
+    }
+
+    ApplicationOptions app_options;
+    if (!parse_app_options(args, app_options)) {
+        std::println(std::cerr, "usage: RTX [--device index|name] [--width N] [--height N] [--no-async-compute] [--cold-pipeline-cache] [--cluster-benchmark] [--refit-benchmark]");
+        std::println(std::cerr, "       RTX --headless [--device index|name] [--width N] [--height N] [--frames N] [--output file.pfm] [--json file] [--cold-pipeline-cache] [--cluster-benchmark] [--refit-benchmark]");
+        return 1;
+    }
+
+    Application* app = new Application(app_options);
     app->run();
     delete app;
 }
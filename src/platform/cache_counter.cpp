@@ -0,0 +1,60 @@
+#include "cache_counter.hpp"
+
+#if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+CacheMissCounter::CacheMissCounter()
+{
+#if defined(__linux__)
+    perf_event_attr attr {};
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    m_fd = static_cast<i32>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+}
+
+CacheMissCounter::~CacheMissCounter()
+{
+#if defined(__linux__)
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+#endif
+}
+
+auto CacheMissCounter::start() -> void
+{
+#if defined(__linux__)
+    if (m_fd < 0) return;
+
+    ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+}
+
+auto CacheMissCounter::stop() -> u64
+{
+#if defined(__linux__)
+    if (m_fd < 0) return 0;
+
+    ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+
+    u64 count = 0;
+    if (read(m_fd, &count, sizeof(count)) != sizeof(count)) {
+        return 0;
+    }
+
+    return count;
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+// hardware last level cache misses of the calling thread, backed by perf events on linux. elsewhere, or when the
+// kernel refuses access (perf_event_paranoid, containers), available() is false and stop() returns 0
+class CacheMissCounter
+{
+public:
+    CacheMissCounter();
+    ~CacheMissCounter();
+
+    CacheMissCounter(const CacheMissCounter&) = delete;
+    CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+    [[nodiscard]] auto available() const -> bool { return m_fd >= 0; }
+
+    auto start() -> void;
+    // misses since start
+    auto stop() -> u64;
+
+private:
+    i32 m_fd { -1 };
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+class MappedFile
+{
+public:
+    MappedFile(const std::filesystem::path& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    [[nodiscard]] auto valid() const -> bool { return m_data != nullptr; }
+
+    [[nodiscard]] auto data() const -> const std::byte* { return m_data; }
+    [[nodiscard]] auto size() const -> usize { return m_size; }
+    [[nodiscard]] auto bytes() const -> std::span<const std::byte> { return { m_data, m_size }; }
+
+private:
+    const std::byte* m_data { nullptr };
+    usize m_size { 0 };
+
+#ifdef _WIN32
+    void* m_file { nullptr };
+    void* m_mapping { nullptr };
+#else
+    i32 m_fd { -1 };
+#endif
+};
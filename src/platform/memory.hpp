@@ -0,0 +1,4 @@
+#pragma once
+
+// high-water mark of the process resident set in bytes, 0 when unavailable
+auto peak_memory_usage() -> u64;
@@ -0,0 +1,13 @@
+#pragma once
+
+// runs fn(0) .. fn(count - 1) on one thread each and returns once all of them are done
+template <typename Fn>
+auto parallel_for(usize count, Fn&& fn) -> void
+{
+    std::vector<std::jthread> workers;
+    workers.reserve(count);
+
+    for (usize i = 0; i < count; ++i) {
+        workers.emplace_back([&fn, i] { fn(i); });
+    }
+}
@@ -41,8 +41,14 @@ namespace RHI {
     {
     }
 
-    auto BLAS::Input::add_geometry(const Buffer& vertex_buffer, u32 vertex_count, u32 vertex_stride, const Buffer& index_buffer, u32 index_count, bool opaque) -> void
+    auto BLAS::Input::add_geometry(
+        const Buffer& vertex_buffer, u32 vertex_count, u32 vertex_stride, VkFormat vertex_format,
+        const Buffer& index_buffer, VkIndexType index_type, u32 first_index, u32 index_count,
+        bool opaque, const Buffer* transform
+    ) -> void
     {
+        u32 index_size = (index_type == VK_INDEX_TYPE_UINT16) ? sizeof(u16) : sizeof(u32);
+
         geometries.push_back(VkAccelerationStructureGeometryKHR {
             .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR,
             .pNext = nullptr,
@@ -51,21 +57,21 @@ namespace RHI {
                 .triangles = {
                     .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR,
                     .pNext = nullptr,
-                    .vertexFormat = VK_FORMAT_R32G32B32_SFLOAT,
+                    .vertexFormat = vertex_format,
                     .vertexData = { .deviceAddress = vertex_buffer.address() },
                     .vertexStride = vertex_stride,
                     .maxVertex = vertex_count,
-                    .indexType = VK_INDEX_TYPE_UINT32,
+                    .indexType = index_type,
                     .indexData = { .deviceAddress = index_buffer.address() },
-                    .transformData = {}
+                    .transformData = { .deviceAddress = transform ? transform->address() : 0 }
                 }
             },
-            .flags = 0
+            .flags = opaque ? VK_GEOMETRY_OPAQUE_BIT_KHR : VK_GEOMETRY_NO_DUPLICATE_ANY_HIT_INVOCATION_BIT_KHR
         });
 
         ranges.push_back(VkAccelerationStructureBuildRangeInfoKHR {
             .primitiveCount = index_count / 3,
-            .primitiveOffset = 0,
+            .primitiveOffset = first_index * index_size,
             .firstVertex = 0,
             .transformOffset = 0
         });
@@ -100,11 +106,16 @@ namespace RHI {
 
         usize count = 0;
         for (const auto& input : inputs) {
+            VkBuildAccelerationStructureFlagsKHR flags = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR | VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR;
+            if (input.allow_update) {
+                flags |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR;
+            }
+
             build_infos.push_back(VkAccelerationStructureBuildGeometryInfoKHR {
                 .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
                 .pNext = nullptr,
                 .type = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR,
-                .flags = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR | VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR,
+                .flags = flags,
                 .mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR,
                 .srcAccelerationStructure = VK_NULL_HANDLE,
                 .dstAccelerationStructure = VK_NULL_HANDLE,
@@ -131,6 +142,7 @@ namespace RHI {
             total_scratch += vkutils::align_up(size_info.buildScratchSize, m_device->as_props().minAccelerationStructureScratchOffsetAlignment);
 
             blases.push_back(std::make_unique<BLAS>(m_device, size_info.accelerationStructureSize));
+            blases.back()->m_flags = flags;
 
             build_infos.back().dstAccelerationStructure = blases.back()->as();
             range_ptrs.push_back(input.ranges.data());
@@ -167,11 +179,16 @@ namespace RHI {
     {
         std::vector<std::unique_ptr<BLAS>> compacted;
 
+        u64 original_size = 0;
+        u64 compacted_size = 0;
+
         std::vector<VkDeviceSize> compact_sizes(blases.size());
         VK_CHECK(vkGetQueryPoolResults(m_device->device(), m_query.back(), 0, static_cast<u32>(blases.size()), compact_sizes.size() * sizeof(VkDeviceSize), compact_sizes.data(), sizeof(VkDeviceSize), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
 
         for (usize i = 0; i < compact_sizes.size(); ++i) {
             auto& new_blas = compacted.emplace_back(std::make_unique<BLAS>(m_device, compact_sizes[i]));
+            // a compacted copy stays updatable if the source was
+            new_blas->m_flags = blases[i]->m_flags;
 
             VkCopyAccelerationStructureInfoKHR copy_info {
                 .sType = VK_STRUCTURE_TYPE_COPY_ACCELERATION_STRUCTURE_INFO_KHR,
@@ -183,13 +200,18 @@ namespace RHI {
 
             vkCmdCopyAccelerationStructureKHR(cmd, &copy_info);
 
-            std::println("compacted blas: {} -> {} ({:.1f}\% smaller)",
-                blases[i]->buffer().size(),
-                new_blas->buffer().size(),
-                static_cast<f32>(blases[i]->buffer().size() - new_blas->buffer().size()) / static_cast<f32>(blases[i]->buffer().size()) * 100.0f
-            );
+            original_size += blases[i]->buffer().size();
+            compacted_size += new_blas->buffer().size();
         }
 
+        // clustered and lod scenes compact hundreds of blases, one summary line keeps the log readable
+        std::println("compacted {} blases: {} -> {} ({:.1f}\% smaller)",
+            blases.size(),
+            original_size,
+            compacted_size,
+            original_size > 0 ? static_cast<f32>(original_size - compacted_size) / static_cast<f32>(original_size) * 100.0f : 0.0f
+        );
+
         auto barrier = BarrierBatch(cmd);
         for (const auto& blas : compacted) {
             barrier = barrier.buffer(blas->buffer(), VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_COPY_BIT_KHR, VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR, VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR);
@@ -199,6 +221,71 @@ namespace RHI {
         return compacted;
     }
 
+    auto AccelerationStructureBuilder::refit_blas(VkCommandBuffer cmd, BLAS& blas, const BLAS::Input& input, VkPipelineStageFlags2 vertex_stage, VkAccessFlags2 vertex_access) -> void
+    {
+        assert(blas.updatable());
+
+        VkAccelerationStructureBuildGeometryInfoKHR build_info {
+            .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
+            .pNext = nullptr,
+            .type = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR,
+            .flags = blas.m_flags,
+            .mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_UPDATE_KHR,
+            .srcAccelerationStructure = blas.as(),
+            .dstAccelerationStructure = blas.as(),
+            .geometryCount = static_cast<u32>(input.geometries.size()),
+            .pGeometries = input.geometries.data(),
+            .ppGeometries = nullptr,
+            .scratchData = {}
+        };
+
+        std::vector<u32> max_prims;
+        max_prims.reserve(input.ranges.size());
+        for (const auto& range : input.ranges) {
+            max_prims.push_back(range.primitiveCount);
+        }
+
+        VkAccelerationStructureBuildSizesInfoKHR size_info {
+            .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_SIZES_INFO_KHR,
+            .pNext = nullptr
+        };
+
+        vkGetAccelerationStructureBuildSizesKHR(m_device->device(), VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR, &build_info, max_prims.data(), &size_info);
+
+        // the update overwrites the blas in place: earlier traces, tlas builds and refits must be done with it, and the
+        // new positions must be visible to the build, which reads its inputs as shader reads
+        auto barrier = BarrierBatch(cmd);
+        barrier
+            .buffer(blas.buffer(), VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR, VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR)
+            .memory(vertex_stage, vertex_access, VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR);
+
+        u64 scratch_size = vkutils::align_up(size_info.updateScratchSize, m_device->as_props().minAccelerationStructureScratchOffsetAlignment);
+        if (!m_update_scratch || m_update_scratch->size() < scratch_size) {
+            // the old buffer may still be referenced by recorded refits, it is released with the other scratch
+            if (m_update_scratch) {
+                m_scratch.push_back(std::move(m_update_scratch));
+            }
+            m_update_scratch = std::make_unique<Buffer>(m_device, scratch_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
+        } else {
+            // the previous refit in this command buffer may still be using the scratch
+            barrier.buffer(*m_update_scratch, VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR, VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR);
+        }
+
+        barrier.insert();
+
+        build_info.scratchData.deviceAddress = m_update_scratch->address();
+
+        const VkAccelerationStructureBuildRangeInfoKHR* p_ranges = input.ranges.data();
+        vkCmdBuildAccelerationStructuresKHR(cmd, 1, &build_info, &p_ranges);
+
+        // the blas was read by traces of the previous frame and is read again by the next tlas build
+        BarrierBatch(cmd)
+            .buffer(blas.buffer(), VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR, VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR | VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR)
+            .insert();
+
+        blas.m_refit_count++;
+    }
+
     auto AccelerationStructureBuilder::build_tlas(VkCommandBuffer cmd, const TLAS::Input& input) -> std::unique_ptr<TLAS>
     {
         u64 instance_buffer_size = input.instances.size() * sizeof(VkAccelerationStructureInstanceKHR);
@@ -279,6 +366,7 @@ namespace RHI {
     auto AccelerationStructureBuilder::cleanup() -> void
     {
         m_scratch.clear();
+        m_update_scratch.reset();
         m_staging.clear();
 
         for (auto& query : m_query) {
@@ -38,12 +38,27 @@ namespace RHI {
             std::vector<VkAccelerationStructureGeometryKHR> geometries;
             std::vector<VkAccelerationStructureBuildRangeInfoKHR> ranges;
 
-            auto add_geometry(const Buffer& vertex_buffer, u32 vertex_count, u32 vertex_stride, const Buffer& index_buffer, u32 index_count, bool opaque = true) -> void;
+            // keeps the blas refittable for deforming meshes, costs some trace speed and a larger structure
+            bool allow_update { false };
+
+            // first_index selects a range of a shared index buffer, transparent geometry keeps any-hit but runs it once per primitive
+            auto add_geometry(const Buffer& vertex_buffer, u32 vertex_count, u32 vertex_stride, VkFormat vertex_format,
+                const Buffer& index_buffer, VkIndexType index_type, u32 first_index, u32 index_count,
+                bool opaque = true, const Buffer* transform = nullptr) -> void;
         };
 
     public:
         BLAS(const std::shared_ptr<Device>& device, u64 size);
         virtual ~BLAS() = default;
+
+        [[nodiscard]] auto flags() const -> VkBuildAccelerationStructureFlagsKHR { return m_flags; }
+        [[nodiscard]] auto updatable() const -> bool { return (m_flags & VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR) != 0; }
+        [[nodiscard]] auto refit_count() const -> u32 { return m_refit_count; }
+
+    private:
+        // updates must be recorded with the flags of the original build
+        VkBuildAccelerationStructureFlagsKHR m_flags { 0 };
+        u32 m_refit_count { 0 };
     };
 
     class TLAS final : public AccelerationStructure
@@ -75,6 +90,15 @@ namespace RHI {
         auto build_blas(VkCommandBuffer cmd, const std::vector<BLAS::Input>& inputs) -> std::vector<std::unique_ptr<BLAS>>;
         auto compact_blas(VkCommandBuffer cmd, const std::vector<std::unique_ptr<BLAS>>& blases) -> std::vector<std::unique_ptr<BLAS>>;
 
+        // in place update of a blas built with allow_update. the input must match the build in geometry and primitive
+        // counts, only vertex positions may change. the tree topology is kept, so trace cost creeps up with every
+        // refit: track Bvh::quality_decay on the host copy of the same vertices and rebuild once it says so. vertex_stage
+        // and vertex_access name the writes that produced the new positions in this queue, traces and tlas builds still
+        // reading the blas are waited on inside
+        auto refit_blas(VkCommandBuffer cmd, BLAS& blas, const BLAS::Input& input,
+            VkPipelineStageFlags2 vertex_stage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+            VkAccessFlags2 vertex_access = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT) -> void;
+
         auto build_tlas(VkCommandBuffer cmd, const TLAS::Input& input) -> std::unique_ptr<TLAS>;
 
         auto cleanup() -> void;
@@ -87,6 +111,8 @@ namespace RHI {
         std::shared_ptr<Device> m_device;
 
         std::vector<std::unique_ptr<Buffer>> m_scratch;
+        // reused by every refit, grown on demand
+        std::unique_ptr<Buffer> m_update_scratch;
         std::vector<std::unique_ptr<Buffer>> m_staging;
         std::vector<VkQueryPool> m_query;
     };
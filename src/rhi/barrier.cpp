@@ -17,6 +17,12 @@ namespace RHI {
         u32 dst_queue
     ) -> BarrierBatch&
     {
+        // a transfer to the same family is an ordinary barrier
+        if (src_queue == dst_queue) {
+            src_queue = VK_QUEUE_FAMILY_IGNORED;
+            dst_queue = VK_QUEUE_FAMILY_IGNORED;
+        }
+
         m_buffers.push_back(VkBufferMemoryBarrier2 {
             .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
             .pNext = nullptr,
@@ -47,6 +53,11 @@ namespace RHI {
         u32 dst_queue
     ) -> BarrierBatch&
     {
+        if (src_queue == dst_queue) {
+            src_queue = VK_QUEUE_FAMILY_IGNORED;
+            dst_queue = VK_QUEUE_FAMILY_IGNORED;
+        }
+
         m_images.push_back(VkImageMemoryBarrier2 {
             .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
             .pNext = nullptr,
@@ -90,6 +101,69 @@ namespace RHI {
         return *this;
     }
 
+    auto BarrierBatch::release_buffer(
+        const Buffer& buffer,
+        VkPipelineStageFlags2 src_stage,
+        VkAccessFlags2 src_access,
+        u32 src_queue,
+        u32 dst_queue
+    ) -> BarrierBatch&
+    {
+        if (src_queue == dst_queue) return *this;
+
+        // the destination scope is ignored on release
+        return this->buffer(buffer, src_stage, src_access, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, src_queue, dst_queue);
+    }
+
+    auto BarrierBatch::acquire_buffer(
+        const Buffer& buffer,
+        VkPipelineStageFlags2 dst_stage,
+        VkAccessFlags2 dst_access,
+        u32 src_queue,
+        u32 dst_queue
+    ) -> BarrierBatch&
+    {
+        if (src_queue == dst_queue) return *this;
+
+        // the source scope is ignored on acquire, the semaphore wait orders it after the release
+        return this->buffer(buffer, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, dst_stage, dst_access, src_queue, dst_queue);
+    }
+
+    auto BarrierBatch::release_image(
+        const Image& image,
+        VkPipelineStageFlags2 src_stage,
+        VkAccessFlags2 src_access,
+        VkImageLayout old_layout,
+        VkImageLayout new_layout,
+        VkImageAspectFlags aspect,
+        u32 src_queue,
+        u32 dst_queue
+    ) -> BarrierBatch&
+    {
+        // same family: a plain transition that completes before the semaphore signal
+        if (src_queue == dst_queue) {
+            return this->image(image, src_stage, src_access, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_NONE, old_layout, new_layout, aspect);
+        }
+
+        return this->image(image, src_stage, src_access, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, old_layout, new_layout, aspect, src_queue, dst_queue);
+    }
+
+    auto BarrierBatch::acquire_image(
+        const Image& image,
+        VkPipelineStageFlags2 dst_stage,
+        VkAccessFlags2 dst_access,
+        VkImageLayout old_layout,
+        VkImageLayout new_layout,
+        VkImageAspectFlags aspect,
+        u32 src_queue,
+        u32 dst_queue
+    ) -> BarrierBatch&
+    {
+        if (src_queue == dst_queue) return *this;
+
+        return this->image(image, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, dst_stage, dst_access, old_layout, new_layout, aspect, src_queue, dst_queue);
+    }
+
     auto BarrierBatch::insert() -> void
     {
         if (m_memory.empty() && m_buffers.empty() && m_images.empty()) return;
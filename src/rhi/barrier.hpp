@@ -42,6 +42,48 @@ namespace RHI {
             VkAccessFlags2 dst_access
         ) -> BarrierBatch&;
 
+        // the two halves of a queue family ownership transfer, recorded into the releasing and the acquiring queue's
+        // commands with matching arguments. the submissions must be ordered by a semaphore, which already makes the
+        // writes visible, so when both families are the same the buffer halves are dropped and only the release
+        // remains for images, to do the layout transition
+        auto release_buffer(
+            const Buffer& buffer,
+            VkPipelineStageFlags2 src_stage,
+            VkAccessFlags2 src_access,
+            u32 src_queue,
+            u32 dst_queue
+        ) -> BarrierBatch&;
+
+        auto acquire_buffer(
+            const Buffer& buffer,
+            VkPipelineStageFlags2 dst_stage,
+            VkAccessFlags2 dst_access,
+            u32 src_queue,
+            u32 dst_queue
+        ) -> BarrierBatch&;
+
+        auto release_image(
+            const Image& image,
+            VkPipelineStageFlags2 src_stage,
+            VkAccessFlags2 src_access,
+            VkImageLayout old_layout,
+            VkImageLayout new_layout,
+            VkImageAspectFlags aspect,
+            u32 src_queue,
+            u32 dst_queue
+        ) -> BarrierBatch&;
+
+        auto acquire_image(
+            const Image& image,
+            VkPipelineStageFlags2 dst_stage,
+            VkAccessFlags2 dst_access,
+            VkImageLayout old_layout,
+            VkImageLayout new_layout,
+            VkImageAspectFlags aspect,
+            u32 src_queue,
+            u32 dst_queue
+        ) -> BarrierBatch&;
+
         auto insert() -> void;
 
     private:
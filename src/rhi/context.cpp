@@ -105,7 +105,7 @@ namespace RHI {
 
         extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 
-        {
+        if (window) {
             u32 glfw_extension_count = 0;
             const char** glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
             extensions.insert(extensions.end(), glfw_extensions, glfw_extensions + glfw_extension_count);
@@ -147,12 +147,16 @@ namespace RHI {
             std::println(" - {}", extension);
         }
 
-        VK_CHECK(glfwCreateWindowSurface(m_instance, static_cast<GLFWwindow*>(window), nullptr, &m_surface));
+        if (window) {
+            VK_CHECK(glfwCreateWindowSurface(m_instance, static_cast<GLFWwindow*>(window), nullptr, &m_surface));
+        }
     }
 
     Context::~Context()
     {
-        vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+        if (m_surface != VK_NULL_HANDLE) {
+            vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+        }
         vkDestroyDebugUtilsMessengerEXT(m_instance, m_messenger, nullptr);
         vkDestroyInstance(m_instance, nullptr);
     }
@@ -9,6 +9,7 @@ namespace RHI {
     class Context
     {
     public:
+        // a null window makes a headless context: no surface and no window system extensions
         Context(GLFWwindow* window);
         ~Context();
 
@@ -17,6 +18,7 @@ namespace RHI {
 
         [[nodiscard]] auto instance() const -> VkInstance   { return m_instance; }
         [[nodiscard]] auto surface()  const -> VkSurfaceKHR { return m_surface; }
+        [[nodiscard]] auto headless() const -> bool { return m_surface == VK_NULL_HANDLE; }
 
     private:
         VkInstance m_instance { VK_NULL_HANDLE };
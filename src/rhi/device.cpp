@@ -2,22 +2,45 @@
 
 namespace RHI {
 
-    Device::Device(const std::shared_ptr<Context>& context)
-        : m_context(context)
-    {
-        u32 device_count = 0;
-        vkEnumeratePhysicalDevices(context->instance(), &device_count, nullptr);
-        std::vector<VkPhysicalDevice> available_devices(device_count);
-        vkEnumeratePhysicalDevices(context->instance(), &device_count, available_devices.data());
+    namespace {
+
+        auto required_extensions(const Context& context) -> std::vector<const char*>
+        {
+            std::vector<const char*> extensions {
+                VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME,
+                VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME,
+                VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME,
+                VK_KHR_RAY_TRACING_MAINTENANCE_1_EXTENSION_NAME
+            };
+
+            if (!context.headless()) {
+                extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+            }
 
-        for (const auto& device : available_devices) {
-            VkPhysicalDeviceProperties props;
-            vkGetPhysicalDeviceProperties(device, &props);
+            return extensions;
+        }
 
-            if (!(props.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)) {
-                continue;
+        auto type_name(VkPhysicalDeviceType type) -> std::string_view
+        {
+            switch (type) {
+                case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: return "discrete";
+                case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return "integrated";
+                case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: return "virtual";
+                case VK_PHYSICAL_DEVICE_TYPE_CPU: return "cpu";
+                default: return "other";
             }
+        }
+
+        auto contains_ignore_case(std::string_view text, std::string_view pattern) -> bool
+        {
+            auto lower = [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); };
+            return !std::ranges::search(text, pattern, {}, lower, lower).empty();
+        }
 
+        // prefers families that do nothing else, so async compute and transfer get their own hardware queues, and
+        // falls back to whatever family can do the work when there are none
+        auto find_queues(VkPhysicalDevice device, const Context& context) -> std::optional<QueueFamilyIndices>
+        {
             u32 queue_count = 0;
             vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_count, nullptr);
             std::vector<VkQueueFamilyProperties> available_queues(queue_count);
@@ -27,59 +50,277 @@ namespace RHI {
             std::optional<u32> compute;
             std::optional<u32> transfer;
 
-            u32 queue_index = 0;
-            for (const auto& queue : available_queues) {
-                VkBool32 present = VK_FALSE;
-                vkGetPhysicalDeviceSurfaceSupportKHR(device, queue_index, context->surface(), &present);
+            std::optional<u32> any_compute;
+            std::optional<u32> compute_only;
 
-                if ((queue.queueFlags & VK_QUEUE_GRAPHICS_BIT) && present == VK_TRUE) {
+            for (u32 queue_index = 0; queue_index < queue_count; ++queue_index) {
+                VkQueueFlags flags = available_queues[queue_index].queueFlags;
+
+                // headless contexts never present, any graphics family will do
+                VkBool32 present = VK_TRUE;
+                if (!context.headless()) {
+                    vkGetPhysicalDeviceSurfaceSupportKHR(device, queue_index, context.surface(), &present);
+                }
+
+                if ((flags & VK_QUEUE_GRAPHICS_BIT) && present == VK_TRUE) {
                     if (!graphics.has_value()) graphics = queue_index;
                 }
 
-                if ((queue.queueFlags & VK_QUEUE_COMPUTE_BIT) && !(queue.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
-                    if (!compute.has_value()) compute = queue_index;
+                if (flags & VK_QUEUE_COMPUTE_BIT) {
+                    if (!any_compute.has_value()) any_compute = queue_index;
                 }
 
-                if ((queue.queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queue.queueFlags & VK_QUEUE_COMPUTE_BIT) && !(queue.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+                if ((flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT)) {
+                    if (!compute_only.has_value()) compute_only = queue_index;
+                }
+
+                if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT)) {
                     if (!transfer.has_value()) transfer = queue_index;
                 }
+            }
+
+            if (!any_compute.has_value()) return std::nullopt;
+
+            compute = compute_only.has_value() ? compute_only : any_compute;
+
+            // the windowed frame loop blits on the graphics queue, headless frames never leave the compute queue, so
+            // there graphics may alias it on compute only devices
+            if (!graphics.has_value()) {
+                if (!context.headless()) return std::nullopt;
+                graphics = compute;
+            }
+
+            // graphics and compute families implicitly support transfers
+            if (!transfer.has_value()) transfer = compute;
+
+            return QueueFamilyIndices {
+                .graphics = graphics.value(),
+                .compute = compute.value(),
+                .transfer = transfer.value()
+            };
+        }
+
+        auto missing_extension(VkPhysicalDevice device, const Context& context) -> std::string_view
+        {
+            u32 extension_count = 0;
+            vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, nullptr);
+            std::vector<VkExtensionProperties> available_extensions(extension_count);
+            vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, available_extensions.data());
+
+            for (const char* extension : required_extensions(context)) {
+                bool found = std::ranges::any_of(available_extensions, [extension](const VkExtensionProperties& props) {
+                    return std::strcmp(props.extensionName, extension) == 0;
+                });
+
+                if (!found) return extension;
+            }
+
+            return {};
+        }
+
+        // mirrors the feature chain enabled at device creation
+        auto missing_feature(VkPhysicalDevice device) -> std::string_view
+        {
+            VkPhysicalDeviceRayTracingMaintenance1FeaturesKHR rt_maintenance {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_MAINTENANCE_1_FEATURES_KHR,
+                .pNext = nullptr
+            };
+
+            VkPhysicalDeviceRayTracingPipelineFeaturesKHR rt_features {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_FEATURES_KHR,
+                .pNext = &rt_maintenance
+            };
+
+            VkPhysicalDeviceAccelerationStructureFeaturesKHR as_features {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR,
+                .pNext = &rt_features
+            };
+
+            VkPhysicalDeviceVulkan14Features features14 {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_4_FEATURES,
+                .pNext = &as_features
+            };
+
+            VkPhysicalDeviceVulkan13Features features13 {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+                .pNext = &features14
+            };
+
+            VkPhysicalDeviceVulkan12Features features12 {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+                .pNext = &features13
+            };
+
+            VkPhysicalDeviceFeatures2 features {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                .pNext = &features12
+            };
+
+            vkGetPhysicalDeviceFeatures2(device, &features);
+
+            if (!rt_features.rayTracingPipeline) return "rayTracingPipeline";
+            if (!rt_maintenance.rayTracingMaintenance1) return "rayTracingMaintenance1";
+            if (!as_features.accelerationStructure) return "accelerationStructure";
+            if (!features12.timelineSemaphore) return "timelineSemaphore";
+            if (!features12.bufferDeviceAddress) return "bufferDeviceAddress";
+            if (!features12.scalarBlockLayout) return "scalarBlockLayout";
+            if (!features13.synchronization2) return "synchronization2";
+            if (!features13.dynamicRendering) return "dynamicRendering";
+            if (!features14.pushDescriptor) return "pushDescriptor";
+            if (!features.features.samplerAnisotropy) return "samplerAnisotropy";
+
+            return {};
+        }
+
+    }
+
+    auto Device::evaluate(VkPhysicalDevice device, const Context& context) -> Candidate
+    {
+        Candidate candidate {
+            .device = device
+        };
+
+        vkGetPhysicalDeviceProperties(device, &candidate.props);
+
+        if (candidate.props.apiVersion < VK_API_VERSION_1_4) {
+            candidate.rejection = "vulkan 1.4 required";
+            return candidate;
+        }
+
+        if (auto extension = missing_extension(device, context); !extension.empty()) {
+            candidate.rejection = std::format("missing {}", extension);
+            return candidate;
+        }
+
+        if (auto feature = missing_feature(device); !feature.empty()) {
+            candidate.rejection = std::format("missing feature {}", feature);
+            return candidate;
+        }
 
-                queue_index++;
+        auto queues = find_queues(device, context);
+        if (!queues.has_value()) {
+            candidate.rejection = context.headless() ? "no compute queue" : "no graphics queue that can present";
+            return candidate;
+        }
+
+        candidate.queues = queues.value();
+
+        // the device type dominates, then separate queue families for async compute and transfer, then memory
+        switch (candidate.props.deviceType) {
+            case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: candidate.score = 4000; break;
+            case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: candidate.score = 3000; break;
+            case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: candidate.score = 2000; break;
+            case VK_PHYSICAL_DEVICE_TYPE_CPU: candidate.score = 1000; break;
+            default: candidate.score = 0; break;
+        }
+
+        if (candidate.queues.compute != candidate.queues.graphics) candidate.score += 200;
+        if (candidate.queues.transfer != candidate.queues.compute && candidate.queues.transfer != candidate.queues.graphics) candidate.score += 100;
+
+        VkPhysicalDeviceMemoryProperties memory;
+        vkGetPhysicalDeviceMemoryProperties(device, &memory);
+
+        u64 local_memory = 0;
+        for (u32 i = 0; i < memory.memoryHeapCount; ++i) {
+            if (memory.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+                local_memory = std::max(local_memory, memory.memoryHeaps[i].size);
+            }
+        }
+
+        candidate.score += static_cast<i64>(std::min<u64>(local_memory >> 30, 99));
+
+        return candidate;
+    }
+
+    Device::Device(const std::shared_ptr<Context>& context, std::string_view preference)
+        : m_context(context)
+    {
+        u32 device_count = 0;
+        vkEnumeratePhysicalDevices(context->instance(), &device_count, nullptr);
+        std::vector<VkPhysicalDevice> available_devices(device_count);
+        vkEnumeratePhysicalDevices(context->instance(), &device_count, available_devices.data());
+
+        std::string env_preference;
+        if (preference.empty()) {
+            if (const char* env = std::getenv("RTX_DEVICE")) {
+                env_preference = env;
+                preference = env_preference;
             }
+        }
+
+        std::vector<Candidate> candidates;
+        candidates.reserve(available_devices.size());
 
-            if (graphics.has_value() && compute.has_value() && transfer.has_value()) {
-                m_physical_device = device;
+        std::println("physical devices:");
+        for (u32 i = 0; i < available_devices.size(); ++i) {
+            Candidate candidate = evaluate(available_devices[i], *context);
 
-                m_queue_indices.graphics = graphics.value();
-                m_queue_indices.compute  = compute.value();
-                m_queue_indices.transfer = transfer.value();
-                
-                m_rt_props = VkPhysicalDeviceRayTracingPipelinePropertiesKHR {
-                    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_PROPERTIES_KHR,
-                    .pNext = nullptr
-                };
+            if (candidate.rejection.empty()) {
+                std::println(" - [{}] {} ({}), score {}", i, candidate.props.deviceName, type_name(candidate.props.deviceType), candidate.score);
+                candidates.push_back(candidate);
+            } else {
+                std::println(" - [{}] {} ({}), unsuitable: {}", i, candidate.props.deviceName, type_name(candidate.props.deviceType), candidate.rejection);
+            }
+        }
 
-                m_as_props = VkPhysicalDeviceAccelerationStructurePropertiesKHR {
-                    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_PROPERTIES_KHR,
-                    .pNext = &m_rt_props
-                };
+        const Candidate* chosen = nullptr;
 
-                m_props = VkPhysicalDeviceProperties2 {
-                    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
-                    .pNext = &m_as_props
-                };
+        if (!preference.empty()) {
+            u32 preferred_index = 0;
+            auto [next, ec] = std::from_chars(preference.data(), preference.data() + preference.size(), preferred_index);
+            bool by_index = ec == std::errc() && next == preference.data() + preference.size();
 
-                vkGetPhysicalDeviceProperties2(m_physical_device, &m_props);
+            for (const auto& candidate : candidates) {
+                bool match = by_index
+                    ? candidate.device == (preferred_index < available_devices.size() ? available_devices[preferred_index] : VK_NULL_HANDLE)
+                    : contains_ignore_case(candidate.props.deviceName, preference);
 
-                std::println("physical device : {}", m_props.properties.deviceName);
-                std::println("graphics queue index : {}", m_queue_indices.graphics);
-                std::println("compute queue index  : {}", m_queue_indices.compute);
-                std::println("transfer queue index : {}", m_queue_indices.transfer);
+                if (match) {
+                    chosen = &candidate;
+                    break;
+                }
+            }
 
-                break;
+            if (!chosen) {
+                std::println(std::cerr, "requested device \"{}\" is missing or unsuitable, picking by score", preference);
             }
         }
 
+        if (!chosen) {
+            auto best = std::ranges::max_element(candidates, {}, &Candidate::score);
+            if (best != candidates.end()) chosen = &*best;
+        }
+
+        if (!chosen) {
+            std::println(std::cerr, "no vulkan device supports ray tracing pipelines, acceleration structures, timeline semaphores and synchronization2");
+            std::exit(EXIT_FAILURE);
+        }
+
+        m_physical_device = chosen->device;
+        m_queue_indices = chosen->queues;
+
+        m_rt_props = VkPhysicalDeviceRayTracingPipelinePropertiesKHR {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_PROPERTIES_KHR,
+            .pNext = nullptr
+        };
+
+        m_as_props = VkPhysicalDeviceAccelerationStructurePropertiesKHR {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_PROPERTIES_KHR,
+            .pNext = &m_rt_props
+        };
+
+        m_props = VkPhysicalDeviceProperties2 {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+            .pNext = &m_as_props
+        };
+
+        vkGetPhysicalDeviceProperties2(m_physical_device, &m_props);
+
+        std::println("physical device : {}", m_props.properties.deviceName);
+        std::println("graphics queue index : {}", m_queue_indices.graphics);
+        std::println("compute queue index  : {}", m_queue_indices.compute);
+        std::println("transfer queue index : {}", m_queue_indices.transfer);
+
         std::set<u32> indices {
             m_queue_indices.graphics,
             m_queue_indices.compute,
@@ -163,13 +404,7 @@ namespace RHI {
             }
         };
 
-        std::vector<const char*> extensions {
-            VK_KHR_SWAPCHAIN_EXTENSION_NAME,
-            VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME,
-            VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME,
-            VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME,
-            VK_KHR_RAY_TRACING_MAINTENANCE_1_EXTENSION_NAME
-        };
+        std::vector<const char*> extensions = required_extensions(*context);
 
         VkDeviceCreateInfo device_info {
             .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
@@ -219,6 +454,14 @@ namespace RHI {
         vkDestroyDevice(m_device, nullptr);
     }
 
+    auto Device::supports_as_vertex_format(VkFormat format) const -> bool
+    {
+        VkFormatProperties props;
+        vkGetPhysicalDeviceFormatProperties(m_physical_device, format, &props);
+
+        return (props.bufferFeatures & VK_FORMAT_FEATURE_ACCELERATION_STRUCTURE_VERTEX_BUFFER_BIT_KHR) != 0;
+    }
+
     auto Device::wait_idle() const -> void
     {
         vkDeviceWaitIdle(m_device);
@@ -15,7 +15,9 @@ namespace RHI {
     class Device
     {
     public:
-        Device(const std::shared_ptr<Context>& context);
+        // devices are scored on type, dedicated queue families and memory after the ray tracing requirements are
+        // met. preference, or RTX_DEVICE when empty, picks one by index or name substring instead
+        Device(const std::shared_ptr<Context>& context, std::string_view preference = {});
         ~Device();
 
         Device(const Device&) = delete;
@@ -33,8 +35,24 @@ namespace RHI {
         [[nodiscard]] auto as_props() const -> VkPhysicalDeviceAccelerationStructurePropertiesKHR { return m_as_props; }
         [[nodiscard]] auto rt_props() const -> VkPhysicalDeviceRayTracingPipelinePropertiesKHR { return m_rt_props; }
 
+        [[nodiscard]] auto supports_as_vertex_format(VkFormat format) const -> bool;
+
         auto wait_idle() const -> void;
 
+    private:
+        struct Candidate
+        {
+            VkPhysicalDevice device { VK_NULL_HANDLE };
+            VkPhysicalDeviceProperties props {};
+            QueueFamilyIndices queues;
+
+            i64 score { 0 };
+            // empty when the device can run the renderer
+            std::string rejection;
+        };
+
+        static auto evaluate(VkPhysicalDevice device, const Context& context) -> Candidate;
+
     private:
         std::shared_ptr<Context> m_context;
 
@@ -0,0 +1,220 @@
+#include "pipeline.hpp"
+
+namespace RHI {
+
+    RayTracingPipeline::Builder::Builder(const std::shared_ptr<Device>& device)
+        : m_device(device)
+    {
+    }
+
+    auto RayTracingPipeline::Builder::add_stage(const Shader& shader) -> u32
+    {
+        m_stages.push_back(shader.stage_info());
+        return static_cast<u32>(m_stages.size() - 1);
+    }
+
+    auto RayTracingPipeline::Builder::add_raygen(const Shader& shader) -> Builder&
+    {
+        m_raygen_groups.push_back(VkRayTracingShaderGroupCreateInfoKHR {
+            .sType = VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR,
+            .pNext = nullptr,
+            .type = VK_RAY_TRACING_SHADER_GROUP_TYPE_GENERAL_KHR,
+            .generalShader = add_stage(shader),
+            .closestHitShader = VK_SHADER_UNUSED_KHR,
+            .anyHitShader = VK_SHADER_UNUSED_KHR,
+            .intersectionShader = VK_SHADER_UNUSED_KHR,
+            .pShaderGroupCaptureReplayHandle = nullptr
+        });
+
+        return *this;
+    }
+
+    auto RayTracingPipeline::Builder::add_miss(const Shader& shader) -> Builder&
+    {
+        m_miss_groups.push_back(VkRayTracingShaderGroupCreateInfoKHR {
+            .sType = VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR,
+            .pNext = nullptr,
+            .type = VK_RAY_TRACING_SHADER_GROUP_TYPE_GENERAL_KHR,
+            .generalShader = add_stage(shader),
+            .closestHitShader = VK_SHADER_UNUSED_KHR,
+            .anyHitShader = VK_SHADER_UNUSED_KHR,
+            .intersectionShader = VK_SHADER_UNUSED_KHR,
+            .pShaderGroupCaptureReplayHandle = nullptr
+        });
+
+        return *this;
+    }
+
+    auto RayTracingPipeline::Builder::add_hit_group(const Shader* closest_hit, const Shader* any_hit) -> Builder&
+    {
+        m_hit_groups.push_back(VkRayTracingShaderGroupCreateInfoKHR {
+            .sType = VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR,
+            .pNext = nullptr,
+            .type = VK_RAY_TRACING_SHADER_GROUP_TYPE_TRIANGLES_HIT_GROUP_KHR,
+            .generalShader = VK_SHADER_UNUSED_KHR,
+            .closestHitShader = closest_hit ? add_stage(*closest_hit) : VK_SHADER_UNUSED_KHR,
+            .anyHitShader = any_hit ? add_stage(*any_hit) : VK_SHADER_UNUSED_KHR,
+            .intersectionShader = VK_SHADER_UNUSED_KHR,
+            .pShaderGroupCaptureReplayHandle = nullptr
+        });
+
+        return *this;
+    }
+
+    auto RayTracingPipeline::Builder::add_layout(const DescriptorLayout& layout) -> Builder&
+    {
+        m_layouts.push_back(layout.layout());
+        return *this;
+    }
+
+    auto RayTracingPipeline::Builder::cache(const PipelineCache& cache) -> Builder&
+    {
+        m_cache = cache.cache();
+        return *this;
+    }
+
+    auto RayTracingPipeline::Builder::max_recursion(u32 depth) -> Builder&
+    {
+        m_max_recursion = std::min(depth, m_device->rt_props().maxRayRecursionDepth);
+        return *this;
+    }
+
+    auto RayTracingPipeline::Builder::build() -> std::unique_ptr<RayTracingPipeline>
+    {
+        std::vector<VkRayTracingShaderGroupCreateInfoKHR> groups;
+        groups.reserve(m_raygen_groups.size() + m_miss_groups.size() + m_hit_groups.size());
+        groups.insert(groups.end(), m_raygen_groups.begin(), m_raygen_groups.end());
+        groups.insert(groups.end(), m_miss_groups.begin(), m_miss_groups.end());
+        groups.insert(groups.end(), m_hit_groups.begin(), m_hit_groups.end());
+
+        return std::make_unique<RayTracingPipeline>(m_device, m_stages, groups, m_layouts, m_max_recursion,
+            static_cast<u32>(m_raygen_groups.size()), static_cast<u32>(m_miss_groups.size()), static_cast<u32>(m_hit_groups.size()),
+            m_cache
+        );
+    }
+
+    RayTracingPipeline::RayTracingPipeline(const std::shared_ptr<Device>& device,
+        std::span<const VkPipelineShaderStageCreateInfo> stages,
+        std::span<const VkRayTracingShaderGroupCreateInfoKHR> groups,
+        std::span<const VkDescriptorSetLayout> layouts,
+        u32 max_recursion, u32 raygen_count, u32 miss_count, u32 hit_count,
+        VkPipelineCache cache)
+        : m_device(device), m_raygen_count(raygen_count), m_miss_count(miss_count), m_hit_count(hit_count)
+    {
+        VkPipelineLayoutCreateInfo layout_info {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .setLayoutCount = static_cast<u32>(layouts.size()),
+            .pSetLayouts = layouts.data(),
+            .pushConstantRangeCount = 0,
+            .pPushConstantRanges = nullptr
+        };
+
+        VK_CHECK(vkCreatePipelineLayout(device->device(), &layout_info, nullptr, &m_layout));
+
+        VkRayTracingPipelineCreateInfoKHR pipeline_info {
+            .sType = VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_CREATE_INFO_KHR,
+            .pNext = nullptr,
+            .flags = 0,
+            .stageCount = static_cast<u32>(stages.size()),
+            .pStages = stages.data(),
+            .groupCount = static_cast<u32>(groups.size()),
+            .pGroups = groups.data(),
+            .maxPipelineRayRecursionDepth = max_recursion,
+            .pLibraryInfo = nullptr,
+            .pLibraryInterface = nullptr,
+            .pDynamicState = nullptr,
+            .layout = m_layout,
+            .basePipelineHandle = VK_NULL_HANDLE,
+            .basePipelineIndex = -1
+        };
+
+        VK_CHECK(vkCreateRayTracingPipelinesKHR(device->device(), VK_NULL_HANDLE, cache, 1, &pipeline_info, nullptr, &m_pipeline));
+    }
+
+    RayTracingPipeline::~RayTracingPipeline()
+    {
+        vkDestroyPipeline(m_device->device(), m_pipeline, nullptr);
+        vkDestroyPipelineLayout(m_device->device(), m_layout, nullptr);
+    }
+
+    auto RayTracingPipeline::group_handles() const -> std::vector<std::byte>
+    {
+        u32 handle_size = m_device->rt_props().shaderGroupHandleSize;
+
+        std::vector<std::byte> handles(static_cast<usize>(group_count()) * handle_size);
+        VK_CHECK(vkGetRayTracingShaderGroupHandlesKHR(m_device->device(), m_pipeline, 0, group_count(), handles.size(), handles.data()));
+
+        return handles;
+    }
+
+    ShaderBindingTable::ShaderBindingTable(const std::shared_ptr<Device>& device, VkCommandBuffer cmd, const RayTracingPipeline& pipeline, std::vector<std::unique_ptr<Buffer>>& stagings)
+    {
+        const auto& props = device->rt_props();
+
+        u64 handle_size = props.shaderGroupHandleSize;
+        u64 record_size = vkutils::align_up(handle_size, props.shaderGroupHandleAlignment);
+        u64 base_alignment = props.shaderGroupBaseAlignment;
+
+        // the raygen region holds a single record and its size must equal its stride
+        m_raygen.stride = vkutils::align_up(record_size, base_alignment);
+        m_raygen.size = m_raygen.stride;
+
+        m_miss.stride = record_size;
+        m_miss.size = vkutils::align_up(pipeline.miss_count() * record_size, base_alignment);
+
+        m_hit.stride = record_size;
+        m_hit.size = vkutils::align_up(pipeline.hit_count() * record_size, base_alignment);
+
+        u64 miss_offset = m_raygen.size;
+        u64 hit_offset = miss_offset + m_miss.size;
+        u64 table_size = hit_offset + m_hit.size;
+
+        // buffer addresses are only guaranteed the memory alignment, the slack lets the table start on a base boundary
+        u64 buffer_size = table_size + base_alignment - 1;
+
+        m_buffer = std::make_unique<Buffer>(device, buffer_size,
+            VK_BUFFER_USAGE_SHADER_BINDING_TABLE_BIT_KHR | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE
+        );
+
+        VkDeviceAddress address = m_buffer->address();
+        VkDeviceAddress table_address = vkutils::align_up(address, base_alignment);
+        u64 table_offset = table_address - address;
+
+        auto handles = pipeline.group_handles();
+
+        std::vector<std::byte> table(buffer_size, std::byte { 0 });
+
+        auto copy_records = [&](u64 offset, u32 first_group, u32 count) {
+            for (u32 i = 0; i < count; ++i) {
+                std::memcpy(table.data() + table_offset + offset + i * record_size, handles.data() + (first_group + i) * handle_size, handle_size);
+            }
+        };
+
+        // only the first raygen group gets a record, switch entry points by building another table
+        copy_records(0, 0, std::min(pipeline.raygen_count(), 1u));
+        copy_records(miss_offset, pipeline.raygen_count(), pipeline.miss_count());
+        copy_records(hit_offset, pipeline.raygen_count() + pipeline.miss_count(), pipeline.hit_count());
+
+        auto& staging = stagings.emplace_back(std::make_unique<Buffer>(device, buffer_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT));
+        staging->write(table.data(), buffer_size);
+
+        m_buffer->stage(cmd, *staging, VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_BINDING_TABLE_READ_BIT_KHR);
+
+        m_raygen.deviceAddress = table_address;
+        m_miss.deviceAddress = table_address + miss_offset;
+        m_hit.deviceAddress = table_address + hit_offset;
+
+        // empty regions are passed as all zero
+        if (pipeline.miss_count() == 0) m_miss = {};
+        if (pipeline.hit_count() == 0) m_hit = {};
+    }
+
+    auto ShaderBindingTable::trace(VkCommandBuffer cmd, u32 width, u32 height, u32 depth) const -> void
+    {
+        vkCmdTraceRaysKHR(cmd, &m_raygen, &m_miss, &m_hit, &m_callable, width, height, depth);
+    }
+
+}
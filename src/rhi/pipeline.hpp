@@ -0,0 +1,112 @@
+#pragma once
+
+#include "vk_types.hpp"
+#include "device.hpp"
+#include "buffer.hpp"
+#include "shader.hpp"
+#include "descriptor.hpp"
+#include "pipeline_cache.hpp"
+
+namespace RHI {
+
+    class RayTracingPipeline
+    {
+    public:
+        // groups are numbered in the order they are added, raygen first, then miss, then hit groups
+        class Builder
+        {
+        public:
+            Builder(const std::shared_ptr<Device>& device);
+
+            auto add_raygen(const Shader& shader) -> Builder&;
+            auto add_miss(const Shader& shader) -> Builder&;
+            // triangle hit group, either shader may be null
+            auto add_hit_group(const Shader* closest_hit, const Shader* any_hit = nullptr) -> Builder&;
+
+            auto add_layout(const DescriptorLayout& layout) -> Builder&;
+            auto cache(const PipelineCache& cache) -> Builder&;
+            // clamped to the device limit
+            auto max_recursion(u32 depth) -> Builder&;
+
+            auto build() -> std::unique_ptr<RayTracingPipeline>;
+
+        private:
+            auto add_stage(const Shader& shader) -> u32;
+
+        private:
+            std::shared_ptr<Device> m_device;
+
+            std::vector<VkPipelineShaderStageCreateInfo> m_stages;
+            std::vector<VkRayTracingShaderGroupCreateInfoKHR> m_raygen_groups;
+            std::vector<VkRayTracingShaderGroupCreateInfoKHR> m_miss_groups;
+            std::vector<VkRayTracingShaderGroupCreateInfoKHR> m_hit_groups;
+
+            std::vector<VkDescriptorSetLayout> m_layouts;
+            u32 m_max_recursion { 1 };
+
+            VkPipelineCache m_cache { VK_NULL_HANDLE };
+        };
+
+    public:
+        RayTracingPipeline(const std::shared_ptr<Device>& device,
+            std::span<const VkPipelineShaderStageCreateInfo> stages,
+            std::span<const VkRayTracingShaderGroupCreateInfoKHR> groups,
+            std::span<const VkDescriptorSetLayout> layouts,
+            u32 max_recursion, u32 raygen_count, u32 miss_count, u32 hit_count,
+            VkPipelineCache cache = VK_NULL_HANDLE);
+        ~RayTracingPipeline();
+
+        RayTracingPipeline(const RayTracingPipeline&) = delete;
+        RayTracingPipeline& operator=(const RayTracingPipeline&) = delete;
+
+        [[nodiscard]] auto pipeline() const -> VkPipeline { return m_pipeline; }
+        [[nodiscard]] auto layout() const -> VkPipelineLayout { return m_layout; }
+
+        [[nodiscard]] auto raygen_count() const -> u32 { return m_raygen_count; }
+        [[nodiscard]] auto miss_count() const -> u32 { return m_miss_count; }
+        [[nodiscard]] auto hit_count() const -> u32 { return m_hit_count; }
+        [[nodiscard]] auto group_count() const -> u32 { return m_raygen_count + m_miss_count + m_hit_count; }
+
+        // shaderGroupHandleSize bytes per group, in group order
+        [[nodiscard]] auto group_handles() const -> std::vector<std::byte>;
+
+    private:
+        std::shared_ptr<Device> m_device;
+
+        VkPipeline m_pipeline { VK_NULL_HANDLE };
+        VkPipelineLayout m_layout { VK_NULL_HANDLE };
+
+        u32 m_raygen_count { 0 };
+        u32 m_miss_count { 0 };
+        u32 m_hit_count { 0 };
+    };
+
+    // raygen, miss and hit records packed into one device local buffer. records are handle sized, rounded up to
+    // shaderGroupHandleAlignment, and each region starts on shaderGroupBaseAlignment, so the table is as small as the
+    // alignment rules allow
+    class ShaderBindingTable
+    {
+    public:
+        // records the upload into cmd, the staging buffer must outlive its execution
+        ShaderBindingTable(const std::shared_ptr<Device>& device, VkCommandBuffer cmd, const RayTracingPipeline& pipeline, std::vector<std::unique_ptr<Buffer>>& stagings);
+
+        [[nodiscard]] auto raygen() const -> const VkStridedDeviceAddressRegionKHR& { return m_raygen; }
+        [[nodiscard]] auto miss() const -> const VkStridedDeviceAddressRegionKHR& { return m_miss; }
+        [[nodiscard]] auto hit() const -> const VkStridedDeviceAddressRegionKHR& { return m_hit; }
+        [[nodiscard]] auto callable() const -> const VkStridedDeviceAddressRegionKHR& { return m_callable; }
+
+        [[nodiscard]] auto buffer() const -> const Buffer& { return *m_buffer; }
+
+        // the pipeline must be bound
+        auto trace(VkCommandBuffer cmd, u32 width, u32 height, u32 depth = 1) const -> void;
+
+    private:
+        std::unique_ptr<Buffer> m_buffer;
+
+        VkStridedDeviceAddressRegionKHR m_raygen {};
+        VkStridedDeviceAddressRegionKHR m_miss {};
+        VkStridedDeviceAddressRegionKHR m_hit {};
+        VkStridedDeviceAddressRegionKHR m_callable {};
+    };
+
+}
@@ -0,0 +1,127 @@
+#include "pipeline_cache.hpp"
+
+#include <pathconfig.inl>
+
+namespace RHI {
+
+    namespace {
+
+        std::filesystem::path s_cachepath(PathConfig::cache_dir);
+
+        auto read_blob(const std::filesystem::path& path) -> std::vector<std::byte>
+        {
+            std::ifstream file(path, std::ios::ate | std::ios::binary);
+            if (!file.is_open()) return {};
+
+            std::vector<std::byte> blob(static_cast<usize>(file.tellg()));
+
+            file.seekg(0);
+            file.read(reinterpret_cast<char*>(blob.data()), blob.size());
+
+            if (!file.good()) return {};
+
+            return blob;
+        }
+
+    }
+
+    PipelineCache::PipelineCache(const std::shared_ptr<Device>& device, bool cold)
+        : m_device(device)
+    {
+        const auto props = device->props();
+
+        m_path = s_cachepath / std::format("pipelines_{:04x}_{:04x}_{:08x}.bin", props.vendorID, props.deviceID, props.driverVersion);
+
+        std::vector<std::byte> blob;
+        if (!cold) {
+            blob = read_blob(m_path);
+
+            if (!blob.empty() && !validate(blob)) {
+                std::println(std::cerr, "pipeline cache: ignoring stale or corrupt {}", m_path.filename().string());
+                blob.clear();
+            }
+        }
+
+        m_warm = !blob.empty();
+
+        VkPipelineCacheCreateInfo cache_info {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .initialDataSize = blob.size(),
+            .pInitialData = blob.empty() ? nullptr : blob.data()
+        };
+
+        VK_CHECK(vkCreatePipelineCache(device->device(), &cache_info, nullptr, &m_cache));
+
+        std::println("pipeline cache: {} ({} bytes)", m_warm ? "warm" : "cold", blob.size());
+    }
+
+    PipelineCache::~PipelineCache()
+    {
+        save();
+        vkDestroyPipelineCache(m_device->device(), m_cache, nullptr);
+    }
+
+    auto PipelineCache::validate(std::span<const std::byte> blob) const -> bool
+    {
+        if (blob.size() < sizeof(VkPipelineCacheHeaderVersionOne)) return false;
+
+        VkPipelineCacheHeaderVersionOne header;
+        std::memcpy(&header, blob.data(), sizeof(header));
+
+        const auto props = m_device->props();
+
+        return header.headerSize >= sizeof(VkPipelineCacheHeaderVersionOne)
+            && header.headerSize <= blob.size()
+            && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+            && header.vendorID == props.vendorID
+            && header.deviceID == props.deviceID
+            && std::memcmp(header.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+    auto PipelineCache::save() const -> bool
+    {
+        usize size = 0;
+        VK_CHECK(vkGetPipelineCacheData(m_device->device(), m_cache, &size, nullptr));
+
+        std::vector<std::byte> blob(size);
+        VK_CHECK(vkGetPipelineCacheData(m_device->device(), m_cache, &size, blob.data()));
+        blob.resize(size);
+
+        if (blob.empty()) return false;
+
+        std::error_code ec;
+        std::filesystem::create_directories(s_cachepath, ec);
+
+        // written next to the cache and renamed over it, a crash mid write never leaves a truncated blob behind
+        auto temp = std::filesystem::path(m_path).concat(".tmp");
+
+        {
+            std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                std::println(std::cerr, "pipeline cache: failed to open {}", temp.string());
+                return false;
+            }
+
+            file.write(reinterpret_cast<const char*>(blob.data()), blob.size());
+
+            if (!file.good()) {
+                std::println(std::cerr, "pipeline cache: failed to write {}", temp.string());
+                return false;
+            }
+        }
+
+        std::filesystem::rename(temp, m_path, ec);
+        if (ec) {
+            std::println(std::cerr, "pipeline cache: failed to replace {}: {}", m_path.string(), ec.message());
+            std::filesystem::remove(temp, ec);
+            return false;
+        }
+
+        std::println("pipeline cache: wrote {} ({} bytes)", m_path.filename().string(), blob.size());
+
+        return true;
+    }
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "vk_types.hpp"
+#include "device.hpp"
+
+namespace RHI {
+
+    // VkPipelineCache persisted under the cache directory, one file per vendor, device and driver version. the blob
+    // is only handed to the driver when its header matches this device's pipelineCacheUUID, anything else starts
+    // empty and is overwritten on save
+    class PipelineCache
+    {
+    public:
+        // cold skips loading the blob, for measuring startup without it
+        PipelineCache(const std::shared_ptr<Device>& device, bool cold = false);
+        // saves, so the device must be idle
+        ~PipelineCache();
+
+        PipelineCache(const PipelineCache&) = delete;
+        PipelineCache& operator=(const PipelineCache&) = delete;
+
+        [[nodiscard]] auto cache() const -> VkPipelineCache { return m_cache; }
+        [[nodiscard]] auto path() const -> const std::filesystem::path& { return m_path; }
+        // started from a blob on disk
+        [[nodiscard]] auto warm() const -> bool { return m_warm; }
+
+        auto save() const -> bool;
+
+    private:
+        auto validate(std::span<const std::byte> blob) const -> bool;
+
+    private:
+        std::shared_ptr<Device> m_device;
+
+        VkPipelineCache m_cache { VK_NULL_HANDLE };
+        std::filesystem::path m_path;
+        bool m_warm { false };
+    };
+
+}
@@ -3,7 +3,7 @@
 namespace RHI {
 
     Queue::Queue(const std::shared_ptr<Device>& device, u32 queue_index)
-        : m_device(device)
+        : m_device(device), m_family(queue_index)
     {
         vkGetDeviceQueue(device->device(), queue_index, 0, &m_queue);
 
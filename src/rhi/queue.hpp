@@ -15,9 +15,13 @@ namespace RHI {
         Queue& operator=(const Queue&) = delete;
 
         [[nodiscard]] auto queue() const -> VkQueue { return m_queue; }
+        [[nodiscard]] auto family() const -> u32 { return m_family; }
         [[nodiscard]] auto timeline() const -> VkSemaphore { return m_timeline; }
         [[nodiscard]] auto value() const -> u64 { return m_value; }
 
+        // both submit to the same VkQueue, so their work runs in submission order and could share one submission
+        [[nodiscard]] auto aliases(const Queue& other) const -> bool { return m_queue == other.m_queue; }
+
         auto submit(VkCommandBuffer cmd, const std::vector<VkSemaphoreSubmitInfo>& waits, std::vector<VkSemaphoreSubmitInfo>& signals, VkPipelineStageFlags2 stage = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT) -> u64;
         auto wait_info(VkPipelineStageFlags2 stage = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT) const -> VkSemaphoreSubmitInfo;
 
@@ -27,6 +31,7 @@ namespace RHI {
         std::shared_ptr<Device> m_device;
 
         VkQueue m_queue { VK_NULL_HANDLE };
+        u32 m_family { 0 };
         VkSemaphore m_timeline { VK_NULL_HANDLE };
         u64 m_value { 0 };
     };
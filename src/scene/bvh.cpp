@@ -0,0 +1,1037 @@
+#include "bvh.hpp"
+
+#include "platform/parallel.hpp"
+
+namespace {
+
+    // ranges above this are binned across threads and their children built as separate tasks. every task owns a share
+    // of the thread budget and hands half of it to each child, so the build never runs more threads than it was given
+    constexpr u32 s_parallel_threshold = 1 << 14;
+
+    constexpr u32 s_max_bins = 64;
+
+    // past this depth ranges are split at the centroid median, which halves them, so a range of up to 2^32
+    // primitives still ends within Bvh::s_MaxDepth
+    constexpr u32 s_median_depth = Bvh::s_MaxDepth - 32;
+
+    struct BuildPrimitive
+    {
+        Bounds bounds;
+        glm::vec3 centroid;
+    };
+
+    struct Bin
+    {
+        Bounds bounds;
+        u32 count { 0 };
+    };
+
+    using Bins = std::array<Bin, 3 * s_max_bins>;
+
+    struct RangeInfo
+    {
+        Bounds bounds;
+        Bounds centroids;
+    };
+
+    struct Builder
+    {
+        const BvhBuildOptions& options;
+        std::span<const BuildPrimitive> primitives;
+
+        std::vector<u32>& order;
+        std::vector<BvhNode>& nodes;
+
+        std::atomic<u32> node_count { 1 };
+        u32 thread_count;
+        u32 bin_count;
+
+        auto range_info(u32 begin, u32 end, u32 threads) const -> RangeInfo
+        {
+            auto gather = [&](u32 first, u32 last) {
+                RangeInfo info;
+                for (u32 i = first; i < last; ++i) {
+                    const auto& primitive = primitives[order[i]];
+                    info.bounds.expand(primitive.bounds);
+                    info.centroids.expand(primitive.centroid);
+                }
+                return info;
+            };
+
+            u32 count = end - begin;
+            if (count < s_parallel_threshold || threads == 1) {
+                return gather(begin, end);
+            }
+
+            std::vector<RangeInfo> partial(threads);
+            parallel_for(threads, [&](usize t) {
+                u32 first = begin + static_cast<u32>(static_cast<u64>(count) * t / threads);
+                u32 last = begin + static_cast<u32>(static_cast<u64>(count) * (t + 1) / threads);
+                partial[t] = gather(first, last);
+            });
+
+            RangeInfo info;
+            for (const auto& p : partial) {
+                info.bounds.expand(p.bounds);
+                info.centroids.expand(p.centroids);
+            }
+
+            return info;
+        }
+
+        auto bin_index(const glm::vec3& centroid, const Bounds& centroids, i32 axis) const -> u32
+        {
+            f32 extent = centroids.max[axis] - centroids.min[axis];
+            f32 relative = (centroid[axis] - centroids.min[axis]) / extent;
+
+            return std::min(static_cast<u32>(relative * static_cast<f32>(bin_count)), bin_count - 1);
+        }
+
+        // bins of all three axes, laid out axis major
+        auto bin_range(u32 begin, u32 end, const Bounds& centroids, u32 threads) const -> Bins
+        {
+            auto gather = [&](u32 first, u32 last) {
+                Bins bins {};
+                for (u32 i = first; i < last; ++i) {
+                    const auto& primitive = primitives[order[i]];
+                    for (i32 axis = 0; axis < 3; ++axis) {
+                        if (centroids.max[axis] <= centroids.min[axis]) continue;
+
+                        auto& bin = bins[axis * bin_count + bin_index(primitive.centroid, centroids, axis)];
+                        bin.bounds.expand(primitive.bounds);
+                        bin.count++;
+                    }
+                }
+                return bins;
+            };
+
+            u32 count = end - begin;
+            if (count < s_parallel_threshold || threads == 1) {
+                return gather(begin, end);
+            }
+
+            std::vector<Bins> partial(threads);
+            parallel_for(threads, [&](usize t) {
+                u32 first = begin + static_cast<u32>(static_cast<u64>(count) * t / threads);
+                u32 last = begin + static_cast<u32>(static_cast<u64>(count) * (t + 1) / threads);
+                partial[t] = gather(first, last);
+            });
+
+            Bins bins {};
+            for (const auto& p : partial) {
+                for (usize b = 0; b < 3 * bin_count; ++b) {
+                    bins[b].bounds.expand(p[b].bounds);
+                    bins[b].count += p[b].count;
+                }
+            }
+
+            return bins;
+        }
+
+        auto make_leaf(u32 node, u32 begin, u32 end, const Bounds& bounds) -> void
+        {
+            nodes[node] = BvhNode { .bounds = bounds, .first = begin, .count = end - begin };
+        }
+
+        auto median_split(u32 begin, u32 end, const Bounds& centroids) -> u32
+        {
+            glm::vec3 extent = centroids.max - centroids.min;
+            i32 axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+            u32 middle = begin + (end - begin) / 2;
+            std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, [&](u32 a, u32 b) {
+                return primitives[a].centroid[axis] < primitives[b].centroid[axis];
+            });
+
+            return middle;
+        }
+
+        auto build(u32 node, u32 begin, u32 end, u32 depth, u32 threads) -> void
+        {
+            u32 count = end - begin;
+            RangeInfo info = range_info(begin, end, threads);
+
+            if (count == 1) {
+                make_leaf(node, begin, end, info.bounds);
+                return;
+            }
+
+            // skewed inputs can split one primitive off per level, give up on SAH before the depth runs out
+            if (depth >= s_median_depth) {
+                if (count <= options.max_leaf_size) {
+                    make_leaf(node, begin, end, info.bounds);
+                    return;
+                }
+
+                split(node, begin, median_split(begin, end, info.centroids), end, depth, threads, info.bounds);
+                return;
+            }
+
+            // sweep the bins of every axis for the cheapest split plane
+
+            Bins bins = bin_range(begin, end, info.centroids, threads);
+
+            f32 best_cost = std::numeric_limits<f32>::max();
+            i32 best_axis = -1;
+            u32 best_split = 0;
+
+            std::array<f32, s_max_bins> right_area;
+            std::array<u32, s_max_bins> right_count;
+
+            for (i32 axis = 0; axis < 3; ++axis) {
+                if (info.centroids.max[axis] <= info.centroids.min[axis]) continue;
+
+                const Bin* axis_bins = bins.data() + axis * bin_count;
+
+                Bounds right;
+                u32 right_total = 0;
+                for (u32 b = bin_count - 1; b > 0; --b) {
+                    right.expand(axis_bins[b].bounds);
+                    right_total += axis_bins[b].count;
+                    right_area[b] = right.surface_area();
+                    right_count[b] = right_total;
+                }
+
+                Bounds left;
+                u32 left_total = 0;
+                for (u32 b = 1; b < bin_count; ++b) {
+                    left.expand(axis_bins[b - 1].bounds);
+                    left_total += axis_bins[b - 1].count;
+
+                    if (left_total == 0 || right_count[b] == 0) continue;
+
+                    f32 cost = left.surface_area() * static_cast<f32>(left_total) + right_area[b] * static_cast<f32>(right_count[b]);
+                    if (cost < best_cost) {
+                        best_cost = cost;
+                        best_axis = axis;
+                        best_split = b;
+                    }
+                }
+            }
+
+            f32 parent_area = info.bounds.surface_area();
+            f32 leaf_cost = options.intersection_cost * static_cast<f32>(count);
+            f32 split_cost = options.traversal_cost + options.intersection_cost * (parent_area > 0.0f ? best_cost / parent_area : 0.0f);
+
+            u32 middle = 0;
+
+            if (best_axis < 0) {
+                // every centroid coincides, only an arbitrary split can keep leaves small
+                if (count <= options.max_leaf_size) {
+                    make_leaf(node, begin, end, info.bounds);
+                    return;
+                }
+                middle = begin + count / 2;
+            } else {
+                if (count <= options.max_leaf_size && leaf_cost <= split_cost) {
+                    make_leaf(node, begin, end, info.bounds);
+                    return;
+                }
+
+                auto it = std::partition(order.begin() + begin, order.begin() + end, [&](u32 primitive) {
+                    return bin_index(primitives[primitive].centroid, info.centroids, best_axis) < best_split;
+                });
+                middle = static_cast<u32>(std::distance(order.begin(), it));
+            }
+
+            split(node, begin, middle, end, depth, threads, info.bounds);
+        }
+
+        auto split(u32 node, u32 begin, u32 middle, u32 end, u32 depth, u32 threads, const Bounds& bounds) -> void
+        {
+            u32 left = node_count.fetch_add(2, std::memory_order_relaxed);
+            nodes[node] = BvhNode { .bounds = bounds, .first = left, .count = 0 };
+
+            if (end - begin >= s_parallel_threshold && threads > 1) {
+                u32 left_threads = threads / 2;
+                auto task = std::async(std::launch::async, [this, left, begin, middle, depth, left_threads] {
+                    build(left, begin, middle, depth + 1, left_threads);
+                });
+                build(left + 1, middle, end, depth + 1, threads - left_threads);
+                task.get();
+            } else {
+                build(left, begin, middle, depth + 1, threads);
+                build(left + 1, middle, end, depth + 1, threads);
+            }
+        }
+    };
+
+    // binned SAH over prebuilt primitive boxes, fills the nodes and the leaf order
+    auto build_nodes(std::span<const BuildPrimitive> primitives, const BvhBuildOptions& options, std::vector<BvhNode>& nodes, std::vector<u32>& order) -> void
+    {
+        u32 count = static_cast<u32>(primitives.size());
+
+        order.resize(count);
+        std::iota(order.begin(), order.end(), 0u);
+
+        nodes.resize(2 * static_cast<usize>(count) - 1);
+
+        Builder builder {
+            .options = options,
+            .primitives = primitives,
+            .order = order,
+            .nodes = nodes,
+            .thread_count = options.thread_count > 0 ? options.thread_count : std::max(1u, std::thread::hardware_concurrency()),
+            .bin_count = std::clamp(options.bin_count, 2u, s_max_bins)
+        };
+
+        builder.build(0, 0, count, 0, builder.thread_count);
+
+        nodes.resize(builder.node_count.load());
+    }
+
+    // subtrees handed out per refit worker, enough slack to even out unbalanced trees
+    constexpr u32 s_refit_tasks_per_thread = 4;
+
+    struct Refitter
+    {
+        std::span<BvhNode> nodes;
+        std::span<const u32> primitives;
+        std::span<BvhTriangle> leaf_triangles;
+        std::span<const BvhTriangle> source;
+
+        auto refit(u32 index) -> Bounds
+        {
+            auto& node = nodes[index];
+
+            Bounds bounds;
+            if (node.leaf()) {
+                for (u32 i = node.first; i < node.first + node.count; ++i) {
+                    const auto& triangle = leaf_triangles[i] = source[primitives[i]];
+                    bounds.expand(triangle.v0);
+                    bounds.expand(triangle.v1);
+                    bounds.expand(triangle.v2);
+                }
+            } else {
+                bounds = refit(node.first);
+                bounds.expand(refit(node.first + 1));
+            }
+
+            node.bounds = bounds;
+            return bounds;
+        }
+    };
+
+    struct Reference
+    {
+        Bounds bounds;
+        u32 triangle;
+    };
+
+    struct SpatialBin
+    {
+        Bounds bounds;
+        u32 entries { 0 };
+        u32 exits { 0 };
+    };
+
+    struct SplitCandidate
+    {
+        f32 cost { std::numeric_limits<f32>::max() };
+        i32 axis { -1 };
+        u32 split { 0 };
+
+        Bounds left;
+        Bounds right;
+        u32 left_count { 0 };
+        u32 right_count { 0 };
+    };
+
+    auto valid(const Bounds& bounds) -> bool
+    {
+        return bounds.min.x <= bounds.max.x && bounds.min.y <= bounds.max.y && bounds.min.z <= bounds.max.z;
+    }
+
+    auto intersection(const Bounds& a, const Bounds& b) -> Bounds
+    {
+        return Bounds { .min = glm::max(a.min, b.min), .max = glm::min(a.max, b.max) };
+    }
+
+    // bounds of the part of a triangle between two planes on one axis, limited to what the reference already covers
+    auto clip_triangle(const BvhTriangle& triangle, i32 axis, f32 low, f32 high, const Bounds& limit) -> Bounds
+    {
+        const std::array<glm::vec3, 3> vertices { triangle.v0, triangle.v1, triangle.v2 };
+
+        Bounds clipped;
+        for (usize i = 0; i < 3; ++i) {
+            const glm::vec3& a = vertices[i];
+            const glm::vec3& b = vertices[(i + 1) % 3];
+
+            if (a[axis] >= low && a[axis] <= high) {
+                clipped.expand(a);
+            }
+
+            for (f32 plane : { low, high }) {
+                if ((a[axis] < plane && b[axis] > plane) || (a[axis] > plane && b[axis] < plane)) {
+                    glm::vec3 point = glm::mix(a, b, (plane - a[axis]) / (b[axis] - a[axis]));
+                    point[axis] = plane;
+                    clipped.expand(point);
+                }
+            }
+        }
+
+        return intersection(clipped, limit);
+    }
+
+    auto bounds_of(std::span<const Reference> references) -> Bounds
+    {
+        Bounds bounds;
+        for (const auto& reference : references) {
+            bounds.expand(reference.bounds);
+        }
+        return bounds;
+    }
+
+    // SBVH after Stich et al. 2009, object splits as in Builder plus spatial splits that clip straddling triangles
+    struct SpatialBuilder
+    {
+        const BvhBuildOptions& options;
+        std::span<const BvhTriangle> source;
+
+        std::vector<BvhNode>& nodes;
+        std::vector<u32>& primitives;
+        std::vector<BvhTriangle>& triangles;
+
+        u32 bin_count;
+        f32 root_area;
+
+        usize reference_count;
+        usize reference_limit;
+
+        auto object_split(std::span<const Reference> references) const -> SplitCandidate
+        {
+            Bounds centroids;
+            for (const auto& reference : references) {
+                centroids.expand(reference.bounds.center());
+            }
+
+            SplitCandidate best;
+
+            std::array<Bin, s_max_bins> bins;
+            std::array<Bounds, s_max_bins> right_bounds;
+            std::array<u32, s_max_bins> right_count;
+
+            for (i32 axis = 0; axis < 3; ++axis) {
+                f32 extent = centroids.max[axis] - centroids.min[axis];
+                if (extent <= 0.0f) continue;
+
+                bins.fill(Bin {});
+                for (const auto& reference : references) {
+                    f32 relative = (reference.bounds.center()[axis] - centroids.min[axis]) / extent;
+                    u32 b = std::min(static_cast<u32>(relative * static_cast<f32>(bin_count)), bin_count - 1);
+                    bins[b].bounds.expand(reference.bounds);
+                    bins[b].count++;
+                }
+
+                Bounds right;
+                u32 right_total = 0;
+                for (u32 b = bin_count - 1; b > 0; --b) {
+                    right.expand(bins[b].bounds);
+                    right_total += bins[b].count;
+                    right_bounds[b] = right;
+                    right_count[b] = right_total;
+                }
+
+                Bounds left;
+                u32 left_total = 0;
+                for (u32 b = 1; b < bin_count; ++b) {
+                    left.expand(bins[b - 1].bounds);
+                    left_total += bins[b - 1].count;
+
+                    if (left_total == 0 || right_count[b] == 0) continue;
+
+                    f32 cost = left.surface_area() * static_cast<f32>(left_total) + right_bounds[b].surface_area() * static_cast<f32>(right_count[b]);
+                    if (cost < best.cost) {
+                        best = SplitCandidate {
+                            .cost = cost, .axis = axis, .split = b,
+                            .left = left, .right = right_bounds[b],
+                            .left_count = left_total, .right_count = right_count[b]
+                        };
+                    }
+                }
+            }
+
+            return best;
+        }
+
+        auto spatial_bin(const Bounds& bounds, i32 axis, f32 position) const -> u32
+        {
+            f32 relative = (position - bounds.min[axis]) / (bounds.max[axis] - bounds.min[axis]);
+            return static_cast<u32>(std::clamp(static_cast<i32>(relative * static_cast<f32>(bin_count)), 0, static_cast<i32>(bin_count) - 1));
+        }
+
+        auto spatial_plane(const Bounds& bounds, i32 axis, u32 split) const -> f32
+        {
+            return bounds.min[axis] + (bounds.max[axis] - bounds.min[axis]) * static_cast<f32>(split) / static_cast<f32>(bin_count);
+        }
+
+        // bins over the node bounds, each reference is clipped into every bin it spans
+        auto spatial_split(std::span<const Reference> references, const Bounds& bounds) const -> SplitCandidate
+        {
+            SplitCandidate best;
+
+            u32 count = static_cast<u32>(references.size());
+
+            std::array<SpatialBin, s_max_bins> bins;
+            std::array<Bounds, s_max_bins> right_bounds;
+            std::array<u32, s_max_bins> right_count;
+
+            for (i32 axis = 0; axis < 3; ++axis) {
+                if (bounds.max[axis] <= bounds.min[axis]) continue;
+
+                bins.fill(SpatialBin {});
+                for (const auto& reference : references) {
+                    u32 first = spatial_bin(bounds, axis, reference.bounds.min[axis]);
+                    u32 last = spatial_bin(bounds, axis, reference.bounds.max[axis]);
+
+                    if (first == last) {
+                        bins[first].bounds.expand(reference.bounds);
+                    } else {
+                        const auto& triangle = source[reference.triangle];
+                        for (u32 b = first; b <= last; ++b) {
+                            Bounds clipped = clip_triangle(triangle, axis, spatial_plane(bounds, axis, b), spatial_plane(bounds, axis, b + 1), reference.bounds);
+                            if (valid(clipped)) {
+                                bins[b].bounds.expand(clipped);
+                            }
+                        }
+                    }
+
+                    bins[first].entries++;
+                    bins[last].exits++;
+                }
+
+                Bounds right;
+                u32 right_total = 0;
+                for (u32 b = bin_count - 1; b > 0; --b) {
+                    right.expand(bins[b].bounds);
+                    right_total += bins[b].exits;
+                    right_bounds[b] = right;
+                    right_count[b] = right_total;
+                }
+
+                Bounds left;
+                u32 left_total = 0;
+                for (u32 b = 1; b < bin_count; ++b) {
+                    left.expand(bins[b - 1].bounds);
+                    left_total += bins[b - 1].entries;
+
+                    // a side holding every reference would recurse forever
+                    if (left_total == 0 || right_count[b] == 0 || left_total == count || right_count[b] == count) continue;
+
+                    f32 cost = left.surface_area() * static_cast<f32>(left_total) + right_bounds[b].surface_area() * static_cast<f32>(right_count[b]);
+                    if (cost < best.cost) {
+                        best = SplitCandidate {
+                            .cost = cost, .axis = axis, .split = b,
+                            .left = left, .right = right_bounds[b],
+                            .left_count = left_total, .right_count = right_count[b]
+                        };
+                    }
+                }
+            }
+
+            return best;
+        }
+
+        auto make_leaf(u32 node, std::span<const Reference> references, const Bounds& bounds) -> void
+        {
+            nodes[node] = BvhNode { .bounds = bounds, .first = static_cast<u32>(triangles.size()), .count = static_cast<u32>(references.size()) };
+
+            for (const auto& reference : references) {
+                primitives.push_back(reference.triangle);
+                triangles.push_back(source[reference.triangle]);
+            }
+        }
+
+        auto partition_object(std::vector<Reference>& references, const SplitCandidate& split, std::vector<Reference>& left, std::vector<Reference>& right) const -> void
+        {
+            Bounds centroids;
+            for (const auto& reference : references) {
+                centroids.expand(reference.bounds.center());
+            }
+
+            f32 extent = centroids.max[split.axis] - centroids.min[split.axis];
+            for (const auto& reference : references) {
+                f32 relative = (reference.bounds.center()[split.axis] - centroids.min[split.axis]) / extent;
+                u32 b = std::min(static_cast<u32>(relative * static_cast<f32>(bin_count)), bin_count - 1);
+                (b < split.split ? left : right).push_back(reference);
+            }
+        }
+
+        // straddling references go to both sides unless keeping them on one side is cheaper (reference unsplitting)
+        auto partition_spatial(std::vector<Reference>& references, const SplitCandidate& split, const Bounds& bounds, std::vector<Reference>& left, std::vector<Reference>& right) -> void
+        {
+            i32 axis = split.axis;
+            f32 plane = spatial_plane(bounds, axis, split.split);
+
+            Bounds left_bounds = split.left;
+            Bounds right_bounds = split.right;
+            f32 left_count = static_cast<f32>(split.left_count);
+            f32 right_count = static_cast<f32>(split.right_count);
+
+            for (const auto& reference : references) {
+                u32 first = spatial_bin(bounds, axis, reference.bounds.min[axis]);
+                u32 last = spatial_bin(bounds, axis, reference.bounds.max[axis]);
+
+                if (last < split.split) {
+                    left.push_back(reference);
+                    continue;
+                }
+                if (first >= split.split) {
+                    right.push_back(reference);
+                    continue;
+                }
+
+                const auto& triangle = source[reference.triangle];
+                Bounds left_part = clip_triangle(triangle, axis, std::numeric_limits<f32>::lowest(), plane, reference.bounds);
+                Bounds right_part = clip_triangle(triangle, axis, plane, std::numeric_limits<f32>::max(), reference.bounds);
+
+                if (!valid(left_part)) {
+                    right.push_back(reference);
+                    continue;
+                }
+                if (!valid(right_part)) {
+                    left.push_back(reference);
+                    continue;
+                }
+
+                Bounds left_union = left_bounds;
+                left_union.expand(reference.bounds);
+                Bounds right_union = right_bounds;
+                right_union.expand(reference.bounds);
+
+                f32 duplicate = left_bounds.surface_area() * left_count + right_bounds.surface_area() * right_count;
+                f32 only_left = left_union.surface_area() * left_count + right_bounds.surface_area() * (right_count - 1.0f);
+                f32 only_right = left_bounds.surface_area() * (left_count - 1.0f) + right_union.surface_area() * right_count;
+
+                if (only_left < duplicate && only_left <= only_right) {
+                    left.push_back(reference);
+                    left_bounds = left_union;
+                    right_count -= 1.0f;
+                } else if (only_right < duplicate) {
+                    right.push_back(reference);
+                    right_bounds = right_union;
+                    left_count -= 1.0f;
+                } else {
+                    left.push_back(Reference { .bounds = left_part, .triangle = reference.triangle });
+                    right.push_back(Reference { .bounds = right_part, .triangle = reference.triangle });
+                }
+            }
+
+            reference_count += left.size() + right.size() - references.size();
+        }
+
+        auto build(u32 node, std::vector<Reference>& references, const Bounds& bounds, u32 depth) -> void
+        {
+            u32 count = static_cast<u32>(references.size());
+
+            if (count == 1 || depth >= Bvh::s_MaxDepth) {
+                make_leaf(node, references, bounds);
+                return;
+            }
+
+            SplitCandidate object = object_split(references);
+
+            // spatial splits only help where the object split children overlap, and only while the budget lasts
+            SplitCandidate spatial;
+            if (object.axis >= 0) {
+                Bounds overlap = intersection(object.left, object.right);
+                if (valid(overlap) && overlap.surface_area() > options.spatial_overlap * root_area) {
+                    spatial = spatial_split(references, bounds);
+                }
+            }
+
+            bool use_spatial = spatial.axis >= 0 && spatial.cost < object.cost
+                && reference_count + spatial.left_count + spatial.right_count - count <= reference_limit;
+
+            const SplitCandidate& best = use_spatial ? spatial : object;
+
+            f32 parent_area = bounds.surface_area();
+            f32 leaf_cost = options.intersection_cost * static_cast<f32>(count);
+            f32 split_cost = options.traversal_cost + options.intersection_cost * (parent_area > 0.0f ? best.cost / parent_area : 0.0f);
+
+            if (count <= options.max_leaf_size && (best.axis < 0 || leaf_cost <= split_cost)) {
+                make_leaf(node, references, bounds);
+                return;
+            }
+
+            std::vector<Reference> left;
+            std::vector<Reference> right;
+
+            if (best.axis < 0) {
+                // every centroid coincides, only an arbitrary split can keep leaves small
+                left.assign(references.begin(), references.begin() + count / 2);
+                right.assign(references.begin() + count / 2, references.end());
+            } else if (use_spatial) {
+                partition_spatial(references, best, bounds, left, right);
+            } else {
+                partition_object(references, best, left, right);
+            }
+
+            std::vector<Reference>().swap(references);
+
+            u32 first = static_cast<u32>(nodes.size());
+            nodes.resize(nodes.size() + 2);
+            nodes[node] = BvhNode { .bounds = bounds, .first = first, .count = 0 };
+
+            Bounds left_bounds = bounds_of(left);
+            Bounds right_bounds = bounds_of(right);
+
+            build(first, left, left_bounds, depth + 1);
+            build(first + 1, right, right_bounds, depth + 1);
+        }
+    };
+
+    // Moller-Trumbore, returns false outside (tmin, tmax)
+    inline auto intersect_triangle(const BvhTriangle& triangle, const Ray& ray, f32 tmax, f32& t, f32& u, f32& v) -> bool
+    {
+        glm::vec3 e1 = triangle.v1 - triangle.v0;
+        glm::vec3 e2 = triangle.v2 - triangle.v0;
+
+        glm::vec3 p = glm::cross(ray.direction, e2);
+        f32 det = glm::dot(e1, p);
+
+        if (std::abs(det) < 1e-12f) return false;
+
+        f32 inv_det = 1.0f / det;
+
+        glm::vec3 s = ray.origin - triangle.v0;
+        u = glm::dot(s, p) * inv_det;
+        if (u < 0.0f || u > 1.0f) return false;
+
+        glm::vec3 q = glm::cross(s, e1);
+        v = glm::dot(ray.direction, q) * inv_det;
+        if (v < 0.0f || u + v > 1.0f) return false;
+
+        t = glm::dot(e2, q) * inv_det;
+        return t > ray.tmin && t < tmax;
+    }
+
+}
+
+auto Bvh::triangles_of(const Mesh& mesh) -> std::vector<BvhTriangle>
+{
+    std::vector<BvhTriangle> triangles;
+
+    // level 0 submeshes cover one contiguous index range from the start of the buffer
+    usize index_count = 0;
+    if (mesh.lods.empty()) {
+        index_count = mesh.index_count();
+    } else {
+        for (const auto& submesh : mesh.lod_submeshes(0)) {
+            index_count = std::max<usize>(index_count, submesh.index_offset + submesh.index_count);
+        }
+    }
+
+    triangles.reserve(index_count / 3);
+    for (usize i = 0; i + 2 < index_count; i += 3) {
+        triangles.push_back(BvhTriangle {
+            .v0 = mesh.position(mesh.index(i + 0)),
+            .v1 = mesh.position(mesh.index(i + 1)),
+            .v2 = mesh.position(mesh.index(i + 2))
+        });
+    }
+
+    return triangles;
+}
+
+auto Bvh::build(const Mesh& mesh, const BvhBuildOptions& options) -> Bvh
+{
+    return build(triangles_of(mesh), options);
+}
+
+auto Bvh::build(std::span<const BvhTriangle> triangles, const BvhBuildOptions& options) -> Bvh
+{
+    Bvh bvh;
+
+    u32 count = static_cast<u32>(triangles.size());
+    if (count == 0) {
+        return bvh;
+    }
+
+    if (options.spatial_splits) {
+        return build_spatial(triangles, options);
+    }
+
+    std::vector<BuildPrimitive> primitives(count);
+    for (u32 i = 0; i < count; ++i) {
+        auto& primitive = primitives[i];
+        primitive.bounds.expand(triangles[i].v0);
+        primitive.bounds.expand(triangles[i].v1);
+        primitive.bounds.expand(triangles[i].v2);
+        primitive.centroid = primitive.bounds.center();
+    }
+
+    build_nodes(primitives, options, bvh.m_nodes, bvh.m_primitives);
+
+    bvh.m_triangles.reserve(count);
+    for (u32 primitive : bvh.m_primitives) {
+        bvh.m_triangles.push_back(triangles[primitive]);
+    }
+
+    bvh.m_build_cost = bvh.m_cost = bvh.sah_cost();
+
+    return bvh;
+}
+
+auto Bvh::build(std::span<const Bounds> boxes, const BvhBuildOptions& options) -> Bvh
+{
+    Bvh bvh;
+
+    if (boxes.empty()) {
+        return bvh;
+    }
+
+    std::vector<BuildPrimitive> primitives(boxes.size());
+    for (usize i = 0; i < boxes.size(); ++i) {
+        primitives[i] = BuildPrimitive { .bounds = boxes[i], .centroid = boxes[i].center() };
+    }
+
+    build_nodes(primitives, options, bvh.m_nodes, bvh.m_primitives);
+
+    bvh.m_build_cost = bvh.m_cost = bvh.sah_cost();
+
+    return bvh;
+}
+
+auto Bvh::build_spatial(std::span<const BvhTriangle> triangles, const BvhBuildOptions& options) -> Bvh
+{
+    Bvh bvh;
+
+    u32 count = static_cast<u32>(triangles.size());
+
+    std::vector<Reference> references(count);
+    Bounds bounds;
+    for (u32 i = 0; i < count; ++i) {
+        references[i].triangle = i;
+        references[i].bounds.expand(triangles[i].v0);
+        references[i].bounds.expand(triangles[i].v1);
+        references[i].bounds.expand(triangles[i].v2);
+        bounds.expand(references[i].bounds);
+    }
+
+    usize reference_limit = count + static_cast<usize>(static_cast<f64>(count) * std::max(options.duplication_budget, 0.0f));
+
+    bvh.m_nodes.reserve(2 * static_cast<usize>(count));
+    bvh.m_primitives.reserve(reference_limit);
+    bvh.m_triangles.reserve(reference_limit);
+
+    SpatialBuilder builder {
+        .options = options,
+        .source = triangles,
+        .nodes = bvh.m_nodes,
+        .primitives = bvh.m_primitives,
+        .triangles = bvh.m_triangles,
+        .bin_count = std::clamp(options.bin_count, 2u, s_max_bins),
+        .root_area = bounds.surface_area(),
+        .reference_count = count,
+        .reference_limit = reference_limit
+    };
+
+    bvh.m_nodes.resize(1);
+    builder.build(0, references, bounds, 1);
+
+    bvh.m_build_cost = bvh.m_cost = bvh.sah_cost();
+
+    return bvh;
+}
+
+auto Bvh::refit(std::span<const BvhTriangle> triangles, u32 thread_count) -> void
+{
+    if (m_nodes.empty()) return;
+    // box trees carry no triangles to move
+    assert(!m_triangles.empty());
+
+    // spatial split leaves get the full triangle boxes back, still conservative but looser than the clipped ones
+    Refitter refitter {
+        .nodes = m_nodes,
+        .primitives = m_primitives,
+        .leaf_triangles = m_triangles,
+        .source = triangles
+    };
+
+    thread_count = thread_count > 0 ? thread_count : std::max(1u, std::thread::hardware_concurrency());
+
+    if (m_triangles.size() < s_parallel_threshold || thread_count == 1) {
+        refitter.refit(0);
+    } else {
+        // open the top of the tree breadth first until there are enough independent subtrees, the opened nodes
+        // come out parents first so walking them backwards afterwards is bottom-up
+        std::vector<u32> top;
+        std::vector<u32> subtrees { 0 };
+
+        while (subtrees.size() < static_cast<usize>(thread_count) * s_refit_tasks_per_thread) {
+            std::vector<u32> next;
+            next.reserve(subtrees.size() * 2);
+
+            for (u32 index : subtrees) {
+                if (m_nodes[index].leaf()) {
+                    next.push_back(index);
+                } else {
+                    top.push_back(index);
+                    next.push_back(m_nodes[index].first);
+                    next.push_back(m_nodes[index].first + 1);
+                }
+            }
+
+            if (next.size() == subtrees.size()) break;
+            subtrees = std::move(next);
+        }
+
+        std::atomic<usize> next_task { 0 };
+        parallel_for(std::min<usize>(thread_count, subtrees.size()), [&](usize) {
+            for (usize task = next_task++; task < subtrees.size(); task = next_task++) {
+                refitter.refit(subtrees[task]);
+            }
+        });
+
+        for (u32 index : std::views::reverse(top)) {
+            auto& node = m_nodes[index];
+            node.bounds = m_nodes[node.first].bounds;
+            node.bounds.expand(m_nodes[node.first + 1].bounds);
+        }
+    }
+
+    m_cost = sah_cost();
+}
+
+auto Bvh::memory_size() const -> usize
+{
+    return m_nodes.size() * sizeof(BvhNode) + m_primitives.size() * sizeof(u32) + m_triangles.size() * sizeof(BvhTriangle);
+}
+
+auto Bvh::depth() const -> u32
+{
+    if (m_nodes.empty()) return 0;
+
+    u32 max_depth = 0;
+
+    std::vector<std::pair<u32, u32>> stack { { 0, 1 } };
+    while (!stack.empty()) {
+        auto [node, depth] = stack.back();
+        stack.pop_back();
+
+        max_depth = std::max(max_depth, depth);
+
+        if (!m_nodes[node].leaf()) {
+            stack.emplace_back(m_nodes[node].first, depth + 1);
+            stack.emplace_back(m_nodes[node].first + 1, depth + 1);
+        }
+    }
+
+    return max_depth;
+}
+
+auto Bvh::sah_cost(f32 traversal_cost, f32 intersection_cost) const -> f32
+{
+    if (m_nodes.empty()) return 0.0f;
+
+    f32 root_area = m_nodes[0].bounds.surface_area();
+    if (root_area <= 0.0f) return 0.0f;
+
+    f32 cost = 0.0f;
+    for (const auto& node : m_nodes) {
+        f32 probability = node.bounds.surface_area() / root_area;
+        cost += probability * (node.leaf() ? intersection_cost * static_cast<f32>(node.count) : traversal_cost);
+    }
+
+    return cost;
+}
+
+auto Bvh::intersect(const Ray& ray) const -> Hit
+{
+    Hit hit;
+    if (m_nodes.empty()) return hit;
+
+    glm::vec3 inv_direction = 1.0f / ray.direction;
+    f32 tmax = ray.tmax;
+
+    std::array<u32, Bvh::s_StackSize> stack;
+    u32 stack_size = 0;
+
+    if (intersect_bounds(m_nodes[0].bounds, ray.origin, inv_direction, ray.tmin, tmax) == std::numeric_limits<f32>::max()) {
+        return hit;
+    }
+
+    u32 node_index = 0;
+    while (true) {
+        const auto& node = m_nodes[node_index];
+
+        if (node.leaf()) {
+            for (u32 i = node.first; i < node.first + node.count; ++i) {
+                f32 t, u, v;
+                if (intersect_triangle(m_triangles[i], ray, tmax, t, u, v)) {
+                    tmax = t;
+                    hit = Hit { .t = t, .u = u, .v = v, .primitive = m_primitives[i] };
+                }
+            }
+        } else {
+            u32 closer = node.first;
+            u32 farther = node.first + 1;
+
+            f32 t_closer = intersect_bounds(m_nodes[closer].bounds, ray.origin, inv_direction, ray.tmin, tmax);
+            f32 t_farther = intersect_bounds(m_nodes[farther].bounds, ray.origin, inv_direction, ray.tmin, tmax);
+
+            if (t_farther < t_closer) {
+                std::swap(closer, farther);
+                std::swap(t_closer, t_farther);
+            }
+
+            if (t_closer != std::numeric_limits<f32>::max()) {
+                if (t_farther != std::numeric_limits<f32>::max()) {
+                    stack[stack_size++] = farther;
+                }
+                node_index = closer;
+                continue;
+            }
+        }
+
+        // pop, skipping nodes a closer hit has culled since they were pushed
+        bool found = false;
+        while (stack_size > 0) {
+            u32 candidate = stack[--stack_size];
+            if (intersect_bounds(m_nodes[candidate].bounds, ray.origin, inv_direction, ray.tmin, tmax) != std::numeric_limits<f32>::max()) {
+                node_index = candidate;
+                found = true;
+                break;
+            }
+        }
+
+        if (!found) break;
+    }
+
+    return hit;
+}
+
+auto Bvh::occluded(const Ray& ray) const -> bool
+{
+    if (m_nodes.empty()) return false;
+
+    glm::vec3 inv_direction = 1.0f / ray.direction;
+
+    std::array<u32, Bvh::s_StackSize> stack;
+    u32 stack_size = 0;
+
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0) {
+        const auto& node = m_nodes[stack[--stack_size]];
+
+        if (intersect_bounds(node.bounds, ray.origin, inv_direction, ray.tmin, ray.tmax) == std::numeric_limits<f32>::max()) {
+            continue;
+        }
+
+        if (node.leaf()) {
+            for (u32 i = node.first; i < node.first + node.count; ++i) {
+                f32 t, u, v;
+                if (intersect_triangle(m_triangles[i], ray, ray.tmax, t, u, v)) {
+                    return true;
+                }
+            }
+        } else {
+            stack[stack_size++] = node.first;
+            stack[stack_size++] = node.first + 1;
+        }
+    }
+
+    return false;
+}
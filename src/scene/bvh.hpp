@@ -0,0 +1,139 @@
+#pragma once
+
+#include "mesh.hpp"
+
+struct Ray
+{
+    glm::vec3 origin;
+    glm::vec3 direction;
+    f32 tmin { 0.0f };
+    f32 tmax { std::numeric_limits<f32>::max() };
+};
+
+// slab test, the distance the ray enters the box at within [tmin, tmax] or f32 max when it misses
+inline auto intersect_bounds(const Bounds& bounds, const glm::vec3& origin, const glm::vec3& inv_direction, f32 tmin, f32 tmax) -> f32
+{
+    glm::vec3 t0 = (bounds.min - origin) * inv_direction;
+    glm::vec3 t1 = (bounds.max - origin) * inv_direction;
+
+    glm::vec3 slab_min = glm::min(t0, t1);
+    glm::vec3 slab_max = glm::max(t0, t1);
+
+    f32 enter = std::max({ slab_min.x, slab_min.y, slab_min.z, tmin });
+    f32 exit = std::min({ slab_max.x, slab_max.y, slab_max.z, tmax });
+
+    return (enter <= exit) ? enter : std::numeric_limits<f32>::max();
+}
+
+struct Hit
+{
+    f32 t { std::numeric_limits<f32>::max() };
+    f32 u { 0.0f };
+    f32 v { 0.0f };
+    u32 primitive { std::numeric_limits<u32>::max() };
+    // set by two-level queries, index into the instance list
+    u32 instance { std::numeric_limits<u32>::max() };
+
+    [[nodiscard]] auto valid() const -> bool { return primitive != std::numeric_limits<u32>::max(); }
+};
+
+struct BvhTriangle
+{
+    glm::vec3 v0;
+    glm::vec3 v1;
+    glm::vec3 v2;
+};
+
+struct BvhNode
+{
+    Bounds bounds;
+
+    // inner nodes: left child, the right one follows it. leaves: first entry of the primitive list
+    u32 first;
+    // primitives in a leaf, 0 marks an inner node
+    u32 count;
+
+    [[nodiscard]] auto leaf() const -> bool { return count > 0; }
+};
+
+struct BvhBuildOptions
+{
+    // clamped to [2, 64]
+    u32 bin_count { 16 };
+
+    // ranges above this are always split, below it a leaf wins when the SAH says so
+    u32 max_leaf_size { 8 };
+
+    f32 traversal_cost { 1.0f };
+    f32 intersection_cost { 1.0f };
+
+    // worker threads, 0 uses every hardware thread
+    u32 thread_count { 0 };
+
+    // spatial splits (SBVH): triangles straddling a split plane may be referenced from both children when that
+    // lowers the SAH, which pays off for long thin triangles. the spatial build runs on one thread
+    bool spatial_splits { false };
+    // extra leaf references allowed on top of the triangle count, as a fraction of it
+    f32 duplication_budget { 0.3f };
+    // spatial splits are only tried where the object split children overlap by more than this fraction of the root area
+    f32 spatial_overlap { 1e-5f };
+};
+
+// binary binned-SAH BVH over triangles, built on the host as a reference for the driver's BLAS
+class Bvh
+{
+public:
+    // refitted trees are usually rebuilt once their SAH has grown by this factor
+    inline static constexpr f32 s_RebuildThreshold { 1.3f };
+
+    // no build goes deeper, so traversal stacks sized from it cannot overflow
+    inline static constexpr u32 s_MaxDepth { 64 };
+    // a binary traversal leaves at most one sibling pending per level
+    inline static constexpr u32 s_StackSize { s_MaxDepth + 1 };
+
+public:
+    // primitive ids are triangle indices of the full resolution level
+    static auto build(const Mesh& mesh, const BvhBuildOptions& options = {}) -> Bvh;
+    static auto build(std::span<const BvhTriangle> triangles, const BvhBuildOptions& options = {}) -> Bvh;
+    // over plain boxes, leaves list box ids and carry no triangles. spatial splits do not apply
+    static auto build(std::span<const Bounds> boxes, const BvhBuildOptions& options = {}) -> Bvh;
+
+    static auto triangles_of(const Mesh& mesh) -> std::vector<BvhTriangle>;
+
+    // moves the triangles of a deforming mesh without changing the topology, triangles are indexed by primitive id
+    // and the node bounds are recomputed bottom-up. quality drops as triangles drift away from where they were split
+    auto refit(std::span<const BvhTriangle> triangles, u32 thread_count = 0) -> void;
+
+    [[nodiscard]] auto nodes() const -> std::span<const BvhNode> { return m_nodes; }
+    [[nodiscard]] auto primitives() const -> std::span<const u32> { return m_primitives; }
+    [[nodiscard]] auto triangles() const -> std::span<const BvhTriangle> { return m_triangles; }
+
+    [[nodiscard]] auto bounds() const -> Bounds { return m_nodes.empty() ? Bounds {} : m_nodes[0].bounds; }
+    [[nodiscard]] auto depth() const -> u32;
+    // bytes held by nodes, references and leaf triangles
+    [[nodiscard]] auto memory_size() const -> usize;
+
+    // expected cost of a random ray through the root bounds
+    [[nodiscard]] auto sah_cost(f32 traversal_cost = 1.0f, f32 intersection_cost = 1.0f) const -> f32;
+
+    // SAH cost now over the cost right after the last build, 1 until a refit loosens the tree
+    [[nodiscard]] auto quality_decay() const -> f32 { return m_build_cost > 0.0f ? m_cost / m_build_cost : 1.0f; }
+    [[nodiscard]] auto should_rebuild(f32 threshold = s_RebuildThreshold) const -> bool { return quality_decay() > threshold; }
+
+    [[nodiscard]] auto intersect(const Ray& ray) const -> Hit;
+    [[nodiscard]] auto occluded(const Ray& ray) const -> bool;
+
+private:
+    static auto build_spatial(std::span<const BvhTriangle> triangles, const BvhBuildOptions& options) -> Bvh;
+
+private:
+    std::vector<BvhNode> m_nodes;
+
+    // original triangle id per leaf entry, a triangle appears more than once after spatial splits
+    std::vector<u32> m_primitives;
+    // triangles in leaf order so a leaf reads one contiguous block
+    std::vector<BvhTriangle> m_triangles;
+
+    f32 m_build_cost { 0.0f };
+    f32 m_cost { 0.0f };
+};
@@ -0,0 +1,235 @@
+#include "compressed_bvh.hpp"
+
+namespace {
+
+    // smallest power of two step that spans the frame in 255 steps, biased by 127
+    auto frame_exponent(f32 origin, f32 max) -> u8
+    {
+        i32 exponent = 0;
+        std::frexp(std::max((max - origin) / 255.0f, std::numeric_limits<f32>::min()), &exponent);
+
+        exponent = std::clamp(exponent, -126, 127);
+        while (exponent < 127 && origin + 255.0f * std::ldexp(1.0f, exponent) < max) {
+            exponent++;
+        }
+
+        return static_cast<u8>(exponent + 127);
+    }
+
+    // the checks use the kernels' dequantization, origin + q * scale, so the rounding matches exactly
+
+    auto quantize_min(f32 value, f32 origin, f32 scale) -> u8
+    {
+        f32 q = std::clamp(std::floor((value - origin) / scale), 0.0f, 255.0f);
+        while (q > 0.0f && origin + q * scale > value) {
+            q -= 1.0f;
+        }
+        return static_cast<u8>(q);
+    }
+
+    auto quantize_max(f32 value, f32 origin, f32 scale) -> u8
+    {
+        f32 q = std::clamp(std::ceil((value - origin) / scale), 0.0f, 255.0f);
+        while (q < 255.0f && origin + q * scale < value) {
+            q += 1.0f;
+        }
+        return static_cast<u8>(q);
+    }
+
+    template <u32 Width>
+    struct Compressor
+    {
+        using Node = CompressedBvhNode<Width>;
+
+        std::span<const BvhNode> source;
+        std::span<const BvhTriangle> source_triangles;
+        std::span<const u32> source_primitives;
+
+        std::vector<Node>& nodes;
+        std::vector<BvhTriangle>& triangles;
+        std::vector<u32>& primitives;
+
+        // same greedy collapse as WideBvh, the largest inner child is opened until the node is full
+        auto gather(u32 index, std::array<u32, Width>& children) const -> u32
+        {
+            u32 count = 0;
+
+            const auto& root = source[index];
+            if (root.leaf()) {
+                children[count++] = index;
+                return count;
+            }
+
+            children[count++] = root.first;
+            children[count++] = root.first + 1;
+
+            while (count < Width) {
+                i32 best = -1;
+                f32 best_area = -1.0f;
+
+                for (u32 c = 0; c < count; ++c) {
+                    const auto& child = source[children[c]];
+                    if (!child.leaf() && child.bounds.surface_area() > best_area) {
+                        best = static_cast<i32>(c);
+                        best_area = child.bounds.surface_area();
+                    }
+                }
+
+                if (best < 0) break;
+
+                u32 opened = children[best];
+                children[best] = source[opened].first;
+                children[count++] = source[opened].first + 1;
+            }
+
+            return count;
+        }
+
+        static auto oversized(u32 count) -> bool
+        {
+            return count > CompressedBvh<Width>::s_MaxLeafSize;
+        }
+
+        // empty node with its quantization frame and child blocks starting at the current ends
+        auto frame_node(const Bounds& frame, std::array<f32, 3>& scale) const -> Node
+        {
+            Node node {};
+
+            for (i32 axis = 0; axis < 3; ++axis) {
+                node.origin[axis] = frame.min[axis];
+                node.exponent[axis] = frame_exponent(frame.min[axis], frame.max[axis]);
+                scale[axis] = std::ldexp(1.0f, static_cast<i32>(node.exponent[axis]) - 127);
+            }
+
+            node.first_node = static_cast<u32>(nodes.size());
+            node.first_triangle = static_cast<u32>(triangles.size());
+
+            return node;
+        }
+
+        static auto quantize_slot(Node& node, u32 slot, const Bounds& bounds, const std::array<f32, 3>& scale) -> void
+        {
+            node.min_x[slot] = quantize_min(bounds.min.x, node.origin[0], scale[0]);
+            node.min_y[slot] = quantize_min(bounds.min.y, node.origin[1], scale[1]);
+            node.min_z[slot] = quantize_min(bounds.min.z, node.origin[2], scale[2]);
+            node.max_x[slot] = quantize_max(bounds.max.x, node.origin[0], scale[0]);
+            node.max_y[slot] = quantize_max(bounds.max.y, node.origin[1], scale[1]);
+            node.max_z[slot] = quantize_max(bounds.max.z, node.origin[2], scale[2]);
+        }
+
+        auto emit_leaf(Node& node, u32 slot, u32 first, u32 count) -> void
+        {
+            node.meta[slot] = static_cast<u8>(count);
+
+            triangles.insert(triangles.end(), source_triangles.begin() + first, source_triangles.begin() + first + count);
+            primitives.insert(primitives.end(), source_primitives.begin() + first, source_primitives.begin() + first + count);
+        }
+
+        // fills nodes[target] from a binary node, its inner children get a consecutive block at the end
+        auto emit(u32 index, u32 target) -> void
+        {
+            std::array<u32, Width> children;
+            u32 count = gather(index, children);
+
+            std::array<f32, 3> scale;
+            Node node = frame_node(source[index].bounds, scale);
+
+            // leaves too large for the meta byte take an inner slot and are split below it
+            u32 inner_count = 0;
+            for (u32 c = 0; c < count; ++c) {
+                const auto& child = source[children[c]];
+
+                if (child.leaf() && !oversized(child.count)) {
+                    emit_leaf(node, c, child.first, child.count);
+                } else {
+                    node.meta[c] = Node::s_Inner;
+                    inner_count++;
+                }
+
+                quantize_slot(node, c, child.bounds, scale);
+            }
+
+            nodes[target] = node;
+            nodes.resize(nodes.size() + inner_count);
+
+            u32 next = node.first_node;
+            for (u32 c = 0; c < count; ++c) {
+                const auto& child = source[children[c]];
+
+                if (!child.leaf()) {
+                    emit(children[c], next++);
+                } else if (oversized(child.count)) {
+                    emit_split(child.first, child.count, child.bounds, next++);
+                }
+            }
+        }
+
+        // spreads one oversized leaf evenly over the slots of nodes[target], every slot keeps the leaf's bounds
+        auto emit_split(u32 first, u32 count, const Bounds& bounds, u32 target) -> void
+        {
+            std::array<f32, 3> scale;
+            Node node = frame_node(bounds, scale);
+
+            u32 per_slot = (count + Width - 1) / Width;
+            u32 slots = (count + per_slot - 1) / per_slot;
+
+            u32 inner_count = 0;
+            for (u32 c = 0; c < slots; ++c) {
+                u32 slot_count = std::min(per_slot, count - c * per_slot);
+
+                if (oversized(slot_count)) {
+                    node.meta[c] = Node::s_Inner;
+                    inner_count++;
+                } else {
+                    emit_leaf(node, c, first + c * per_slot, slot_count);
+                }
+
+                quantize_slot(node, c, bounds, scale);
+            }
+
+            nodes[target] = node;
+            nodes.resize(nodes.size() + inner_count);
+
+            u32 next = node.first_node;
+            for (u32 c = 0; c < slots; ++c) {
+                u32 slot_count = std::min(per_slot, count - c * per_slot);
+
+                if (oversized(slot_count)) {
+                    emit_split(first + c * per_slot, slot_count, bounds, next++);
+                }
+            }
+        }
+    };
+
+}
+
+template <u32 Width>
+auto CompressedBvh<Width>::build(const Bvh& bvh) -> CompressedBvh
+{
+    CompressedBvh compressed;
+
+    if (bvh.nodes().empty()) {
+        return compressed;
+    }
+
+    compressed.m_nodes.reserve(bvh.nodes().size() / (Width - 1) + 1);
+    compressed.m_triangles.reserve(bvh.triangles().size());
+    compressed.m_primitives.reserve(bvh.primitives().size());
+
+    Compressor<Width> compressor {
+        .source = bvh.nodes(),
+        .source_triangles = bvh.triangles(),
+        .source_primitives = bvh.primitives(),
+        .nodes = compressed.m_nodes,
+        .triangles = compressed.m_triangles,
+        .primitives = compressed.m_primitives
+    };
+
+    compressed.m_nodes.resize(1);
+    compressor.emit(0, 0);
+
+    return compressed;
+}
+
+template class CompressedBvh<4>;
+template class CompressedBvh<8>;
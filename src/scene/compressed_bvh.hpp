@@ -0,0 +1,73 @@
+#pragma once
+
+#include "bvh.hpp"
+
+// 4 or 8 wide node whose child boxes are 8 bit offsets in a per node frame, bounds = origin + q * 2^exponent.
+// 64 bytes for 4 children and 80 for 8, against 256 for the full precision WideBvhNode
+template <u32 Width>
+struct alignas(Width == 4 ? 64 : 16) CompressedBvhNode
+{
+    inline static constexpr u32 s_Width { Width };
+
+    // child meta values, anything else is the triangle count of a leaf child
+    inline static constexpr u8 s_Empty { 0 };
+    inline static constexpr u8 s_Inner { 0xff };
+
+    f32 origin[3];
+    // biased by 127 like an ieee exponent so the scale can be assembled without a call
+    u8 exponent[3];
+    u8 padding;
+
+    // inner children occupy consecutive nodes from here in slot order
+    u32 first_node;
+    // leaf children occupy consecutive triangle ranges from here in slot order
+    u32 first_triangle;
+
+    u8 meta[Width];
+
+    // rounded outwards so the dequantized box always contains the child
+    u8 min_x[Width];
+    u8 min_y[Width];
+    u8 min_z[Width];
+    u8 max_x[Width];
+    u8 max_y[Width];
+    u8 max_z[Width];
+};
+
+static_assert(sizeof(CompressedBvhNode<4>) == 64);
+static_assert(sizeof(CompressedBvhNode<8>) == 80);
+
+// binary BVH collapsed into wide nodes with quantized child bounds, traded against a few extra ALU ops per child
+template <u32 Width>
+class CompressedBvh
+{
+public:
+    static_assert(Width == 4 || Width == 8);
+
+    // triangles a leaf slot can count in its meta byte. larger leaves, which the builder leaves at its depth limit,
+    // become a small tree of extra nodes whose slots share the range, at most s_SplitDepth levels for any u32 count
+    inline static constexpr u32 s_MaxLeafSize { CompressedBvhNode<Width>::s_Inner - 1u };
+    inline static constexpr u32 s_SplitDepth = [] {
+        u32 depth = 1;
+        for (u64 capacity = u64 { s_MaxLeafSize } * Width; capacity <= std::numeric_limits<u32>::max(); capacity *= Width) {
+            depth++;
+        }
+        return depth;
+    }();
+
+    // triangles are reordered so the leaves of a node are contiguous, primitive ids still refer to the mesh
+    static auto build(const Bvh& bvh) -> CompressedBvh;
+
+    [[nodiscard]] auto nodes() const -> std::span<const CompressedBvhNode<Width>> { return m_nodes; }
+    [[nodiscard]] auto primitives() const -> std::span<const u32> { return m_primitives; }
+    [[nodiscard]] auto triangles() const -> std::span<const BvhTriangle> { return m_triangles; }
+
+private:
+    std::vector<CompressedBvhNode<Width>> m_nodes;
+
+    std::vector<u32> m_primitives;
+    std::vector<BvhTriangle> m_triangles;
+};
+
+extern template class CompressedBvh<4>;
+extern template class CompressedBvh<8>;
@@ -0,0 +1,154 @@
+#include "instance_bvh.hpp"
+
+namespace {
+
+    // box of the eight transformed corners
+    auto world_bounds(const Bounds& local, const Transform3x4& transform) -> Bounds
+    {
+        Bounds bounds;
+        if (local.min.x > local.max.x) return bounds;
+
+        for (u32 corner = 0; corner < 8; ++corner) {
+            glm::vec3 point(
+                (corner & 1) ? local.max.x : local.min.x,
+                (corner & 2) ? local.max.y : local.min.y,
+                (corner & 4) ? local.max.z : local.min.z
+            );
+            bounds.expand(transform.point(point));
+        }
+
+        return bounds;
+    }
+
+    // the direction is not renormalized, so t means the same distance in both spaces
+    auto object_ray(const Ray& ray, const Transform3x4& world_to_object, f32 tmax) -> Ray
+    {
+        return Ray {
+            .origin = world_to_object.point(ray.origin),
+            .direction = world_to_object.vector(ray.direction),
+            .tmin = ray.tmin,
+            .tmax = tmax
+        };
+    }
+
+}
+
+auto InstanceBvh::build(std::vector<BvhInstance> instances) -> InstanceBvh
+{
+    InstanceBvh bvh;
+    bvh.m_instances = std::move(instances);
+    bvh.rebuild();
+
+    return bvh;
+}
+
+auto InstanceBvh::set_transform(u32 instance, const Transform3x4& transform) -> void
+{
+    m_instances[instance].transform = transform;
+}
+
+auto InstanceBvh::rebuild() -> void
+{
+    m_world_to_object.resize(m_instances.size());
+
+    std::vector<Bounds> boxes(m_instances.size());
+    for (usize i = 0; i < m_instances.size(); ++i) {
+        const auto& instance = m_instances[i];
+        assert(instance.blas);
+
+        m_world_to_object[i] = instance.transform.inverse();
+        boxes[i] = world_bounds(instance.blas->bounds(), instance.transform);
+    }
+
+    // a few thousand boxes at most, not worth the worker threads
+    m_top = Bvh::build(boxes, BvhBuildOptions { .max_leaf_size = 2, .thread_count = 1 });
+}
+
+auto InstanceBvh::memory_size() const -> usize
+{
+    usize size = m_top.memory_size() + m_instances.size() * (sizeof(BvhInstance) + sizeof(Transform3x4));
+
+    std::unordered_set<const Bvh*> shared;
+    for (const auto& instance : m_instances) {
+        if (shared.insert(instance.blas.get()).second) {
+            size += instance.blas->memory_size();
+        }
+    }
+
+    return size;
+}
+
+auto InstanceBvh::intersect(const Ray& ray) const -> Hit
+{
+    Hit hit;
+
+    auto nodes = m_top.nodes();
+    if (nodes.empty()) return hit;
+
+    glm::vec3 inv_direction = 1.0f / ray.direction;
+    f32 tmax = ray.tmax;
+
+    std::array<u32, Bvh::s_StackSize> stack;
+    u32 stack_size = 0;
+
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0) {
+        const auto& node = nodes[stack[--stack_size]];
+
+        if (intersect_bounds(node.bounds, ray.origin, inv_direction, ray.tmin, tmax) == std::numeric_limits<f32>::max()) continue;
+
+        if (!node.leaf()) {
+            stack[stack_size++] = node.first + 1;
+            stack[stack_size++] = node.first;
+            continue;
+        }
+
+        for (u32 i = node.first; i < node.first + node.count; ++i) {
+            u32 instance = m_top.primitives()[i];
+
+            Hit local = m_instances[instance].blas->intersect(object_ray(ray, m_world_to_object[instance], tmax));
+            if (local.valid()) {
+                hit = local;
+                hit.instance = instance;
+                tmax = local.t;
+            }
+        }
+    }
+
+    return hit;
+}
+
+auto InstanceBvh::occluded(const Ray& ray) const -> bool
+{
+    auto nodes = m_top.nodes();
+    if (nodes.empty()) return false;
+
+    glm::vec3 inv_direction = 1.0f / ray.direction;
+
+    std::array<u32, Bvh::s_StackSize> stack;
+    u32 stack_size = 0;
+
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0) {
+        const auto& node = nodes[stack[--stack_size]];
+
+        if (intersect_bounds(node.bounds, ray.origin, inv_direction, ray.tmin, ray.tmax) == std::numeric_limits<f32>::max()) continue;
+
+        if (!node.leaf()) {
+            stack[stack_size++] = node.first;
+            stack[stack_size++] = node.first + 1;
+            continue;
+        }
+
+        for (u32 i = node.first; i < node.first + node.count; ++i) {
+            u32 instance = m_top.primitives()[i];
+            if (m_instances[instance].blas->occluded(object_ray(ray, m_world_to_object[instance], ray.tmax))) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "bvh.hpp"
+
+// row major 3x4 affine transform, the layout of VkTransformMatrixKHR
+struct Transform3x4
+{
+    std::array<glm::vec4, 3> rows {
+        glm::vec4(1.0f, 0.0f, 0.0f, 0.0f),
+        glm::vec4(0.0f, 1.0f, 0.0f, 0.0f),
+        glm::vec4(0.0f, 0.0f, 1.0f, 0.0f)
+    };
+
+    static auto from(const glm::mat4& matrix) -> Transform3x4
+    {
+        Transform3x4 transform;
+        for (i32 row = 0; row < 3; ++row) {
+            transform.rows[row] = glm::vec4(matrix[0][row], matrix[1][row], matrix[2][row], matrix[3][row]);
+        }
+        return transform;
+    }
+
+    [[nodiscard]] auto matrix() const -> glm::mat4
+    {
+        glm::mat4 matrix(1.0f);
+        for (i32 row = 0; row < 3; ++row) {
+            for (i32 column = 0; column < 4; ++column) {
+                matrix[column][row] = rows[row][column];
+            }
+        }
+        return matrix;
+    }
+
+    [[nodiscard]] auto inverse() const -> Transform3x4 { return from(glm::inverse(matrix())); }
+
+    [[nodiscard]] auto point(const glm::vec3& p) const -> glm::vec3
+    {
+        glm::vec4 h(p, 1.0f);
+        return glm::vec3(glm::dot(rows[0], h), glm::dot(rows[1], h), glm::dot(rows[2], h));
+    }
+
+    [[nodiscard]] auto vector(const glm::vec3& v) const -> glm::vec3
+    {
+        glm::vec4 h(v, 0.0f);
+        return glm::vec3(glm::dot(rows[0], h), glm::dot(rows[1], h), glm::dot(rows[2], h));
+    }
+};
+
+// host counterpart of VkAccelerationStructureInstanceKHR, instances of one mesh share its BLAS
+struct BvhInstance
+{
+    std::shared_ptr<const Bvh> blas;
+    // object to world
+    Transform3x4 transform;
+    u32 custom_index { 0 };
+};
+
+// two level structure mirroring BLAS/TLAS: a small top level BVH over instance boxes whose leaves point at shared
+// per mesh BVHs. moving instances only rebuilds the top level
+class InstanceBvh
+{
+public:
+    static auto build(std::vector<BvhInstance> instances) -> InstanceBvh;
+
+    // takes effect on the next rebuild so several moves share one top level build
+    auto set_transform(u32 instance, const Transform3x4& transform) -> void;
+    auto rebuild() -> void;
+
+    [[nodiscard]] auto instances() const -> std::span<const BvhInstance> { return m_instances; }
+    [[nodiscard]] auto top() const -> const Bvh& { return m_top; }
+    [[nodiscard]] auto bounds() const -> Bounds { return m_top.bounds(); }
+
+    // top level plus every distinct BLAS once
+    [[nodiscard]] auto memory_size() const -> usize;
+
+    // hits carry the instance index, primitive ids are local to that instance's mesh
+    [[nodiscard]] auto intersect(const Ray& ray) const -> Hit;
+    [[nodiscard]] auto occluded(const Ray& ray) const -> bool;
+
+private:
+    std::vector<BvhInstance> m_instances;
+    std::vector<Transform3x4> m_world_to_object;
+
+    Bvh m_top;
+};
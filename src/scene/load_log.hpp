@@ -0,0 +1,45 @@
+#pragma once
+
+// collects the lines a load prints so loads running side by side print one block each instead of interleaving
+class LoadLog
+{
+public:
+    // captures this thread's lines until destroyed, then prints them at once. a nested log hands its lines to the outer one
+    LoadLog()
+        : m_outer(s_active)
+    {
+        s_active = this;
+    }
+
+    ~LoadLog()
+    {
+        s_active = m_outer;
+
+        if (m_outer) {
+            m_outer->m_text += m_text;
+        } else {
+            std::print("{}", m_text);
+        }
+    }
+
+    LoadLog(const LoadLog&) = delete;
+    LoadLog& operator=(const LoadLog&) = delete;
+
+    // straight to stdout when no log is capturing on this thread
+    template <typename... Args>
+    static auto println(std::format_string<Args...> fmt, Args&&... args) -> void
+    {
+        if (s_active) {
+            s_active->m_text += std::format(fmt, std::forward<Args>(args)...);
+            s_active->m_text += '\n';
+        } else {
+            std::println(fmt, std::forward<Args>(args)...);
+        }
+    }
+
+private:
+    inline static thread_local LoadLog* s_active { nullptr };
+
+    LoadLog* m_outer;
+    std::string m_text;
+};
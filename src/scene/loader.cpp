@@ -3,109 +3,833 @@
 #include <tiny_obj_loader.h>
 #include <meshoptimizer.h>
 
+#include "mesh_cache.hpp"
+#include "obj_parser.hpp"
+#include "load_log.hpp"
+
+#include "platform/mapped_file.hpp"
+#include "platform/memory.hpp"
+
 #include <pathconfig.inl>
 
 namespace {
 
     std::filesystem::path s_respath(PathConfig::res_dir);
 
-}
+    struct MeshData
+    {
+        std::vector<Vertex> vertices;
+        std::vector<glm::vec3> positions;
+        std::vector<VertexAttributes> attributes;
+        std::vector<CompactPosition> compact_positions;
+        std::vector<CompactAttributes> compact_attributes;
+        std::vector<u32> indices;
+        std::vector<u16> short_indices;
+
+        std::vector<i32> triangle_materials;
+        std::vector<u32> triangle_clusters;
+        std::vector<Bounds> clusters;
+        std::vector<Submesh> submeshes;
+        std::vector<Material> materials;
+        std::vector<Lod> lods;
+    };
+
+    auto resolve_vertex(const ObjData& obj, const ObjIndex& idx) -> Vertex
+    {
+        Vertex vertex {};
+
+        vertex.position = {
+            obj.positions[3 * idx.position + 0],
+            obj.positions[3 * idx.position + 1],
+            obj.positions[3 * idx.position + 2]
+        };
+
+        if (idx.normal >= 0) {
+            vertex.normal = {
+                obj.normals[3 * idx.normal + 0],
+                obj.normals[3 * idx.normal + 1],
+                obj.normals[3 * idx.normal + 2]
+            };
+        }
 
-auto Loader::load_obj(const std::string& filename) -> Model
-{
-    std::println("loading {}", filename);
+        if (idx.uv >= 0) {
+            vertex.uv = {
+                obj.texcoords[2 * idx.uv + 0],
+                obj.texcoords[2 * idx.uv + 1]
+            };
+        }
 
-    std::string path = (s_respath / filename).string();
-    std::string base_dir = std::filesystem::path(filename).parent_path().string();
+        return vertex;
+    }
+
+    auto valid_triangle(const ObjData& obj, usize first) -> bool
+    {
+        return obj.indices[first].position >= 0 && obj.indices[first + 1].position >= 0 && obj.indices[first + 2].position >= 0;
+    }
 
-    tinyobj::ObjReaderConfig config;
-    config.mtl_search_path = (s_respath / base_dir).string();
+    auto report_dedup(std::string_view mode, usize corners, const MeshData& data, usize transient) -> void
+    {
+        LoadLog::println(" - dedup ({}): {} corners -> {} vertices, {:.1f} MB transient",
+            mode, corners, data.vertices.size(),
+            static_cast<f64>(transient) / (1024.0 * 1024.0)
+        );
+    }
 
-    tinyobj::ObjReader reader;
+    // expands every face corner into a full vertex and lets meshoptimizer find the duplicates
+    auto dedup_expanded(const ObjData& obj) -> MeshData
+    {
+        std::vector<Vertex> raw_vertices;
+        raw_vertices.reserve(obj.indices.size());
 
-    if (!reader.ParseFromFile(path, config)) {
-        if (!reader.Error().empty()) {
-            std::println(std::cerr, "TinObjReader: {}", reader.Error());
+        std::vector<i32> triangle_materials;
+        triangle_materials.reserve(obj.indices.size() / 3);
+
+        for (usize i = 0; i + 2 < obj.indices.size(); i += 3) {
+            if (!valid_triangle(obj, i)) continue;
+
+            raw_vertices.push_back(resolve_vertex(obj, obj.indices[i + 0]));
+            raw_vertices.push_back(resolve_vertex(obj, obj.indices[i + 1]));
+            raw_vertices.push_back(resolve_vertex(obj, obj.indices[i + 2]));
+            triangle_materials.push_back(obj.materials[i / 3]);
         }
+
+        usize index_count = raw_vertices.size();
+        std::vector<u32> remap(index_count);
+
+        usize vertex_count = meshopt_generateVertexRemap(remap.data(), nullptr, index_count, raw_vertices.data(), index_count, sizeof(Vertex));
+
+        MeshData data;
+        data.indices.resize(index_count);
+        data.vertices.resize(vertex_count);
+
+        meshopt_remapIndexBuffer(data.indices.data(), nullptr, index_count, remap.data());
+        meshopt_remapVertexBuffer(data.vertices.data(), raw_vertices.data(), index_count, sizeof(Vertex), remap.data());
+
+        data.triangle_materials = std::move(triangle_materials);
+
+        report_dedup("expanded", index_count, data,
+            raw_vertices.capacity() * sizeof(Vertex) + remap.size() * sizeof(u32) +
+            data.indices.size() * sizeof(u32) + data.vertices.size() * sizeof(Vertex)
+        );
+
+        return data;
     }
 
-    if (!reader.Warning().empty()) {
-        std::println(std::cerr, "TinObjReader: {}", reader.Warning());
+    // hashes the (position, normal, uv) index triples as faces are walked, the expanded corner array never exists
+    auto dedup_streaming(const ObjData& obj) -> MeshData
+    {
+        constexpr u32 empty = std::numeric_limits<u32>::max();
+
+        auto hash_index = [](const ObjIndex& idx) -> u32 {
+            u32 h = static_cast<u32>(idx.position) * 0x9E3779B1u;
+            h ^= static_cast<u32>(idx.normal) * 0x85EBCA77u;
+            h ^= static_cast<u32>(idx.uv) * 0xC2B2AE3Du;
+            h ^= h >> 15;
+            h *= 0x2C1B3C6Du;
+            h ^= h >> 12;
+            return h;
+        };
+
+        // slots hold vertex ids, the keys live once per unique vertex
+        std::vector<u32> slots(std::bit_ceil(std::max<usize>(obj.positions.size() / 3 * 2, 64)), empty);
+        std::vector<ObjIndex> keys;
+
+        MeshData data;
+        data.indices.reserve(obj.indices.size());
+        data.triangle_materials.reserve(obj.indices.size() / 3);
+        data.vertices.reserve(obj.positions.size() / 3);
+        keys.reserve(obj.positions.size() / 3);
+
+        auto insert = [&](const ObjIndex& idx) -> u32 {
+            usize mask = slots.size() - 1;
+            usize slot = hash_index(idx) & mask;
+
+            while (slots[slot] != empty) {
+                const ObjIndex& key = keys[slots[slot]];
+                if (key.position == idx.position && key.normal == idx.normal && key.uv == idx.uv) {
+                    return slots[slot];
+                }
+                slot = (slot + 1) & mask;
+            }
+
+            u32 id = static_cast<u32>(keys.size());
+            slots[slot] = id;
+            keys.push_back(idx);
+            data.vertices.push_back(resolve_vertex(obj, idx));
+
+            return id;
+        };
+
+        auto grow = [&]() {
+            std::vector<u32> larger(slots.size() * 2, empty);
+            usize mask = larger.size() - 1;
+
+            for (u32 id = 0; id < keys.size(); ++id) {
+                usize slot = hash_index(keys[id]) & mask;
+                while (larger[slot] != empty) slot = (slot + 1) & mask;
+                larger[slot] = id;
+            }
+
+            slots = std::move(larger);
+        };
+
+        usize peak_slots = slots.size();
+
+        for (usize i = 0; i + 2 < obj.indices.size(); i += 3) {
+            if (!valid_triangle(obj, i)) continue;
+
+            if ((keys.size() + 3) * 10 > slots.size() * 7) {
+                grow();
+                peak_slots = slots.size();
+            }
+
+            data.indices.push_back(insert(obj.indices[i + 0]));
+            data.indices.push_back(insert(obj.indices[i + 1]));
+            data.indices.push_back(insert(obj.indices[i + 2]));
+            data.triangle_materials.push_back(obj.materials[i / 3]);
+        }
+
+        report_dedup("streaming", data.indices.size(), data,
+            peak_slots * sizeof(u32) + keys.capacity() * sizeof(ObjIndex) +
+            data.indices.capacity() * sizeof(u32) + data.vertices.capacity() * sizeof(Vertex)
+        );
+
+        return data;
     }
 
-    const auto& attrib = reader.GetAttrib();
-    const auto& shapes = reader.GetShapes();
+    // median splits of the triangle centroids along the widest axis until every cluster fits the budget
+    auto partition_clusters(MeshData& data, u32 cluster_triangles) -> void
+    {
+        usize triangle_count = data.indices.size() / 3;
+
+        std::vector<glm::vec3> centroids(triangle_count);
+        for (usize t = 0; t < triangle_count; ++t) {
+            centroids[t] = (
+                data.vertices[data.indices[t * 3 + 0]].position +
+                data.vertices[data.indices[t * 3 + 1]].position +
+                data.vertices[data.indices[t * 3 + 2]].position
+            ) / 3.0f;
+        }
+
+        std::vector<u32> order(triangle_count);
+        std::iota(order.begin(), order.end(), 0u);
 
-    std::vector<Vertex> raw_vertices;
-    raw_vertices.reserve(attrib.vertices.size() / 3);
+        struct Range
+        {
+            usize begin;
+            usize end;
+        };
 
-    for (const auto& shape : shapes) {
-        usize offset = 0;
-        for (usize f = 0; f < shape.mesh.num_face_vertices.size(); ++f) {
-            u8 fv = shape.mesh.num_face_vertices[f];
-            if (fv != 3) {
-                offset += fv;
+        std::vector<Range> pending { Range { .begin = 0, .end = triangle_count } };
+        std::vector<Range> leaves;
+
+        while (!pending.empty()) {
+            Range range = pending.back();
+            pending.pop_back();
+
+            if (cluster_triangles == 0 || range.end - range.begin <= cluster_triangles) {
+                leaves.push_back(range);
                 continue;
             }
 
-            for (usize v = 0; v < 3; ++v) {
-                tinyobj::index_t idx = shape.mesh.indices[offset + v];
+            Bounds bounds;
+            for (usize i = range.begin; i < range.end; ++i) {
+                bounds.expand(centroids[order[i]]);
+            }
+
+            glm::vec3 size = bounds.max - bounds.min;
+            i32 axis = (size.x > size.y && size.x > size.z) ? 0 : (size.y > size.z ? 1 : 2);
+
+            usize middle = range.begin + (range.end - range.begin) / 2;
+            std::nth_element(order.begin() + range.begin, order.begin() + middle, order.begin() + range.end, [&](u32 a, u32 b) {
+                return centroids[a][axis] < centroids[b][axis];
+            });
+
+            // depth first, neighbouring cluster ids stay spatially close
+            pending.push_back(Range { .begin = middle, .end = range.end });
+            pending.push_back(Range { .begin = range.begin, .end = middle });
+        }
+
+        data.triangle_clusters.resize(triangle_count);
+        data.clusters.resize(leaves.size());
+
+        for (u32 c = 0; c < leaves.size(); ++c) {
+            for (usize i = leaves[c].begin; i < leaves[c].end; ++i) {
+                u32 t = order[i];
+                data.triangle_clusters[t] = c;
+
+                for (usize k = 0; k < 3; ++k) {
+                    data.clusters[c].expand(data.vertices[data.indices[t * 3 + k]].position);
+                }
+            }
+        }
+
+        if (leaves.size() > 1) {
+            LoadLog::println(" - clusters: {} of at most {} triangles", leaves.size(), cluster_triangles);
+        }
+    }
+
+    // groups triangles by cluster, then material, so every submesh is one contiguous index range
+    auto build_submeshes(MeshData& data) -> void
+    {
+        usize triangle_count = data.indices.size() / 3;
+        u32 cluster_count = static_cast<u32>(data.clusters.size());
+
+        // -1 (no usemtl, or a name the libraries do not define) goes to a default material at the end
+        u32 fallback = static_cast<u32>(data.materials.size());
+        auto material_of = [&](usize triangle) -> u32 {
+            i32 material = data.triangle_materials[triangle];
+            return (material >= 0 && static_cast<u32>(material) < fallback) ? static_cast<u32>(material) : fallback;
+        };
+
+        u32 material_count = fallback + 1;
+        auto key_of = [&](usize triangle) -> u32 {
+            return data.triangle_clusters[triangle] * material_count + material_of(triangle);
+        };
+
+        std::vector<u32> offsets(cluster_count * material_count + 1, 0);
+        for (usize t = 0; t < triangle_count; ++t) {
+            offsets[key_of(t) + 1]++;
+        }
+
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        bool needs_fallback = false;
+        for (u32 key = 0; key + 1 < offsets.size(); ++key) {
+            u32 count = offsets[key + 1] - offsets[key];
+            if (count == 0) continue;
+
+            u32 material = key % material_count;
+            needs_fallback |= (material == fallback);
+
+            data.submeshes.push_back(Submesh {
+                .index_offset = offsets[key] * 3,
+                .index_count = count * 3,
+                .material = material,
+                .cluster = key / material_count
+            });
+        }
+
+        if (needs_fallback) {
+            data.materials.push_back(Material {});
+        }
+
+        std::vector<u32> sorted(data.indices.size());
+        for (usize t = 0; t < triangle_count; ++t) {
+            u32 slot = offsets[key_of(t)]++;
+            std::copy_n(data.indices.begin() + t * 3, 3, sorted.begin() + slot * 3);
+        }
+
+        data.indices = std::move(sorted);
+        data.triangle_materials = {};
+        data.triangle_clusters = {};
+    }
+
+    // simplifies every submesh of the previous level to half its triangles, borders stay locked so materials do not crack apart
+    auto generate_lods(MeshData& data, u32 lod_count) -> void
+    {
+        constexpr f32 target_ratio = 0.5f;
+        constexpr f32 max_error = 0.05f;
+        constexpr f32 min_reduction = 0.9f;
+
+        data.lods.push_back(Lod { .submesh_offset = 0, .submesh_count = static_cast<u32>(data.submeshes.size()), .error = 0.0f });
+
+        if (lod_count <= 1 || data.vertices.empty()) {
+            return;
+        }
+
+        const f32* positions = &data.vertices[0].position.x;
+        usize vertex_count = data.vertices.size();
+
+        f32 scale = meshopt_simplifyScale(positions, vertex_count, sizeof(Vertex));
+
+        std::vector<u32> simplified;
+
+        while (data.lods.size() < lod_count) {
+            Lod previous = data.lods.back();
+            Lod lod { .submesh_offset = static_cast<u32>(data.submeshes.size()), .submesh_count = 0, .error = previous.error };
+
+            usize index_offset = data.indices.size();
+            usize previous_indices = 0;
+            usize lod_indices = 0;
+
+            for (u32 s = 0; s < previous.submesh_count; ++s) {
+                Submesh source = data.submeshes[previous.submesh_offset + s];
+                previous_indices += source.index_count;
+
+                usize target = static_cast<usize>(static_cast<f32>(source.index_count / 3) * target_ratio) * 3;
+
+                f32 error = 0.0f;
+                simplified.resize(source.index_count);
+                simplified.resize(meshopt_simplify(
+                    simplified.data(), data.indices.data() + source.index_offset, source.index_count,
+                    positions, vertex_count, sizeof(Vertex),
+                    target, max_error, meshopt_SimplifyLockBorder, &error
+                ));
+
+                lod.error = std::max(lod.error, error * scale);
+
+                // never let a cluster disappear from a level, it would leave an empty BLAS behind
+                if (simplified.empty()) {
+                    simplified.assign(data.indices.begin() + source.index_offset, data.indices.begin() + source.index_offset + source.index_count);
+                }
+
+                data.submeshes.push_back(Submesh {
+                    .index_offset = static_cast<u32>(data.indices.size()),
+                    .index_count = static_cast<u32>(simplified.size()),
+                    .material = source.material,
+                    .cluster = source.cluster
+                });
+                data.indices.insert(data.indices.end(), simplified.begin(), simplified.end());
+
+                lod.submesh_count++;
+                lod_indices += simplified.size();
+            }
+
+            // stop once the simplifier hits the error bound, another level would barely shrink
+            if (lod.submesh_count == 0 || static_cast<f32>(lod_indices) > static_cast<f32>(previous_indices) * min_reduction) {
+                data.indices.resize(index_offset);
+                data.submeshes.resize(lod.submesh_offset);
+                break;
+            }
+
+            LoadLog::println(" - lod {}: {} triangles, error {:.5f}", data.lods.size(), lod_indices / 3, lod.error);
+
+            data.lods.push_back(lod);
+        }
+    }
+
+    auto optimize_mesh(MeshData& data) -> void
+    {
+        usize index_count = data.indices.size();
+        usize vertex_count = data.vertices.size();
+
+        // reorder within each submesh, triangles must not cross material boundaries
+        for (const auto& submesh : data.submeshes) {
+            u32* range = data.indices.data() + submesh.index_offset;
+            meshopt_optimizeVertexCache(range, range, submesh.index_count, vertex_count);
+        }
+
+        std::vector<u32> remap(vertex_count);
+        vertex_count = meshopt_optimizeVertexFetchRemap(remap.data(), data.indices.data(), index_count, vertex_count);
+
+        meshopt_remapIndexBuffer(data.indices.data(), data.indices.data(), index_count, remap.data());
+        meshopt_remapVertexBuffer(data.vertices.data(), data.vertices.data(), data.vertices.size(), sizeof(Vertex), remap.data());
+
+        data.vertices.resize(vertex_count);
+    }
+
+    // drops to 16 bit indices when the vertex count allows it, halves index memory for small meshes
+    auto narrow_indices(MeshData& data, usize vertex_count) -> IndexType
+    {
+        if (vertex_count > static_cast<usize>(std::numeric_limits<u16>::max()) + 1) {
+            return IndexType::Uint32;
+        }
+
+        data.short_indices.resize(data.indices.size());
+        std::ranges::transform(data.indices, data.short_indices.begin(), [](u32 index) {
+            return static_cast<u16>(index);
+        });
+
+        data.indices = {};
+
+        return IndexType::Uint16;
+    }
+
+    auto split_streams(MeshData& data) -> void
+    {
+        data.positions.reserve(data.vertices.size());
+        data.attributes.reserve(data.vertices.size());
+
+        for (const auto& vertex : data.vertices) {
+            data.positions.push_back(vertex.position);
+            data.attributes.push_back(VertexAttributes { .normal = vertex.normal, .uv = vertex.uv });
+        }
+
+        data.vertices = {};
+    }
+
+    auto compute_bounds(const MeshData& data) -> Bounds
+    {
+        Bounds bounds;
+        for (const auto& vertex : data.vertices) {
+            bounds.min = glm::min(bounds.min, vertex.position);
+            bounds.max = glm::max(bounds.max, vertex.position);
+        }
+
+        return bounds;
+    }
+
+    auto quantize_streams(MeshData& data, const Mesh& frame) -> void
+    {
+        glm::vec3 offset = frame.dequantize_offset();
+        glm::vec3 scale = frame.dequantize_scale();
 
-                Vertex vertex;
+        data.compact_positions.reserve(data.vertices.size());
+        data.compact_attributes.reserve(data.vertices.size());
 
-                vertex.position = {
-                    attrib.vertices[3 * idx.vertex_index + 0],
-                    attrib.vertices[3 * idx.vertex_index + 1],
-                    attrib.vertices[3 * idx.vertex_index + 2]
+        f32 position_error = 0.0f;
+        f32 normal_error = 0.0f;
+        f32 uv_error = 0.0f;
+
+        for (const auto& vertex : data.vertices) {
+            glm::vec3 local = (vertex.position - offset) / scale;
+
+            CompactPosition position;
+            glm::vec3 decoded;
+
+            if (frame.position_format == PositionFormat::Float16) {
+                position.xyzw = {
+                    Quantization::float_to_half(local.x),
+                    Quantization::float_to_half(local.y),
+                    Quantization::float_to_half(local.z),
+                    0
+                };
+                decoded = glm::vec3(Quantization::half_to_float(position.xyzw[0]), Quantization::half_to_float(position.xyzw[1]), Quantization::half_to_float(position.xyzw[2]));
+            } else {
+                std::array<i16, 3> snorm {
+                    Quantization::float_to_snorm16(local.x),
+                    Quantization::float_to_snorm16(local.y),
+                    Quantization::float_to_snorm16(local.z)
                 };
+                position.xyzw = { static_cast<u16>(snorm[0]), static_cast<u16>(snorm[1]), static_cast<u16>(snorm[2]), 0 };
+                decoded = glm::vec3(Quantization::snorm16_to_float(snorm[0]), Quantization::snorm16_to_float(snorm[1]), Quantization::snorm16_to_float(snorm[2]));
+            }
+
+            glm::vec2 octahedral = Quantization::encode_octahedral(vertex.normal);
+
+            CompactAttributes attributes {
+                .normal = { Quantization::float_to_snorm16(octahedral.x), Quantization::float_to_snorm16(octahedral.y) },
+                .uv = { Quantization::float_to_half(vertex.uv.x), Quantization::float_to_half(vertex.uv.y) }
+            };
+
+            position_error = std::max(position_error, glm::length(offset + decoded * scale - vertex.position));
+
+            if (glm::dot(vertex.normal, vertex.normal) > 0.0f) {
+                glm::vec3 normal = Quantization::decode_octahedral(glm::vec2(Quantization::snorm16_to_float(attributes.normal[0]), Quantization::snorm16_to_float(attributes.normal[1])));
+                f32 cosine = std::clamp(glm::dot(normal, glm::normalize(vertex.normal)), -1.0f, 1.0f);
+                normal_error = std::max(normal_error, std::acos(cosine));
+            }
+
+            uv_error = std::max({ uv_error,
+                std::abs(Quantization::half_to_float(attributes.uv[0]) - vertex.uv.x),
+                std::abs(Quantization::half_to_float(attributes.uv[1]) - vertex.uv.y)
+            });
+
+            data.compact_positions.push_back(position);
+            data.compact_attributes.push_back(attributes);
+        }
+
+        f32 diagonal = glm::length(frame.bounds.max - frame.bounds.min);
+
+        LoadLog::println(" - quantized ({}): position error {:.5f} ({:.4f}% of bounds), normal error {:.3f} deg, uv error {:.5f}",
+            (frame.position_format == PositionFormat::Float16) ? "float16" : "snorm16",
+            position_error,
+            diagonal > 0.0f ? position_error / diagonal * 100.0f : 0.0f,
+            normal_error * 180.0f / std::numbers::pi_v<f32>,
+            uv_error
+        );
+
+        LoadLog::println(" - vertex memory: {:.2f} MB -> {:.2f} MB",
+            static_cast<f64>(data.vertices.size() * sizeof(Vertex)) / (1024.0 * 1024.0),
+            static_cast<f64>(data.vertices.size() * (sizeof(CompactPosition) + sizeof(CompactAttributes))) / (1024.0 * 1024.0)
+        );
+
+        data.vertices = {};
+    }
+
+    auto parse_tinyobj(const std::string& path, const std::string& base_dir, std::vector<tinyobj::material_t>& materials) -> ObjData
+    {
+        tinyobj::ObjReaderConfig config;
+        config.mtl_search_path = (s_respath / base_dir).string();
+
+        tinyobj::ObjReader reader;
 
-                if (idx.normal_index >= 0) {
-                    vertex.normal = {
-                        attrib.normals[3 * idx.normal_index + 0],
-                        attrib.normals[3 * idx.normal_index + 1],
-                        attrib.normals[3 * idx.normal_index + 2]
-                    };
+        if (!reader.ParseFromFile(path, config)) {
+            if (!reader.Error().empty()) {
+                std::println(std::cerr, "TinObjReader: {}", reader.Error());
+            }
+        }
+
+        if (!reader.Warning().empty()) {
+            std::println(std::cerr, "TinObjReader: {}", reader.Warning());
+        }
+
+        const auto& attrib = reader.GetAttrib();
+        const auto& shapes = reader.GetShapes();
+
+        materials = reader.GetMaterials();
+
+        ObjData data {
+            .positions = attrib.vertices,
+            .normals = attrib.normals,
+            .texcoords = attrib.texcoords
+        };
+
+        for (const auto& material : materials) {
+            data.material_names.push_back(material.name);
+        }
+
+        for (const auto& shape : shapes) {
+            usize offset = 0;
+            for (usize f = 0; f < shape.mesh.num_face_vertices.size(); ++f) {
+                u8 fv = shape.mesh.num_face_vertices[f];
+                if (fv != 3) {
+                    offset += fv;
+                    continue;
                 }
 
-                if (idx.texcoord_index >= 0) {
-                    vertex.uv = {
-                        attrib.texcoords[2 * idx.texcoord_index + 0],
-                        attrib.texcoords[2 * idx.texcoord_index + 1]
-                    };
+                for (usize v = 0; v < 3; ++v) {
+                    tinyobj::index_t idx = shape.mesh.indices[offset + v];
+
+                    data.indices.push_back(ObjIndex {
+                        .position = idx.vertex_index,
+                        .normal = idx.normal_index,
+                        .uv = idx.texcoord_index
+                    });
                 }
 
-                raw_vertices.push_back(vertex);
+                data.materials.push_back(shape.mesh.material_ids.empty() ? -1 : shape.mesh.material_ids[f]);
+
+                offset += 3;
             }
+        }
 
-            offset += 3;
+        return data;
+    }
+
+    auto parse_parallel(const std::string& path, u32 thread_count) -> ObjData
+    {
+        MappedFile file(path);
+        if (!file.valid()) {
+            std::println(std::cerr, "ObjParser: failed to open {}", path);
+            return {};
         }
+
+        return ObjParser::parse(file.bytes(), thread_count);
     }
 
-    std::println(" - raw data points: {}", raw_vertices.size());
+    auto load_material_libraries(const ObjData& obj, const std::filesystem::path& directory) -> std::vector<tinyobj::material_t>
+    {
+        std::vector<tinyobj::material_t> materials;
+        std::map<std::string, int> material_map;
 
-    usize index_count = raw_vertices.size();
-    std::vector<u32> remap(index_count);
+        for (const auto& library : obj.material_libraries) {
+            std::ifstream stream(directory / library);
+            if (!stream.is_open()) {
+                std::println(std::cerr, "ObjParser: failed to open material library {}", library);
+                continue;
+            }
 
-    usize vertex_count = meshopt_generateVertexRemap( remap.data(), nullptr, index_count, raw_vertices.data(), index_count, sizeof(Vertex));
+            std::string warning;
+            std::string error;
+            tinyobj::LoadMtl(&material_map, &materials, &stream, &warning, &error);
 
-    std::vector<u32> indices(index_count);
-    std::vector<Vertex> unique_vertices(vertex_count);
+            if (!error.empty()) {
+                std::println(std::cerr, "ObjParser: {}", error);
+            }
+        }
 
-    meshopt_remapIndexBuffer(indices.data(), nullptr, index_count, remap.data());
-    meshopt_remapVertexBuffer(unique_vertices.data(), raw_vertices.data(), index_count, sizeof(Vertex), remap.data());
+        return materials;
+    }
 
-    meshopt_optimizeVertexCache(indices.data(), indices.data(), index_count, vertex_count);
+    auto convert_materials(const ObjData& obj, const std::vector<tinyobj::material_t>& definitions) -> std::vector<Material>
+    {
+        std::vector<Material> materials;
+        materials.reserve(obj.material_names.size());
 
-    std::vector<Vertex> vertices(vertex_count);
+        for (const auto& name : obj.material_names) {
+            auto it = std::ranges::find(definitions, name, &tinyobj::material_t::name);
+            if (it == definitions.end()) {
+                std::println(std::cerr, "ObjParser: material {} is not defined, using the default", name);
+                materials.push_back(Material {});
+                continue;
+            }
+
+            materials.push_back(Material {
+                .diffuse = glm::vec3(it->diffuse[0], it->diffuse[1], it->diffuse[2]),
+                .opacity = it->dissolve,
+                .alpha_tested = it->alpha_texname.empty() ? 0u : 1u
+            });
+        }
 
-    meshopt_optimizeVertexFetch(vertices.data(), indices.data(), index_count, unique_vertices.data(), vertex_count, sizeof(Vertex));
+        return materials;
+    }
 
-    auto mesh = std::make_unique<Mesh>();
-    mesh->indices = std::move(indices);
-    mesh->vertices = std::move(vertices);
+    // everything in the options that changes the imported streams, importer and threading produce identical meshes
+    auto import_settings(const LoadOptions& options) -> u64
+    {
+        PositionFormat format = (options.layout == VertexLayout::Compact) ? options.position_format : PositionFormat::Float32;
+
+        // the dedup modes emit vertices in different orders
+        return static_cast<u64>(options.layout)
+            | (static_cast<u64>(format) << 4)
+            | (static_cast<u64>(options.dedup) << 8)
+            | (static_cast<u64>(options.lod_count & 0xFFFF) << 16)
+            | (static_cast<u64>(options.cluster_triangles) << 32);
+    }
 
-    std::println(" - vertices: {}", mesh->vertices.size());
-    std::println(" - triangles: {}", mesh->indices.size() / 3);
+    auto import_obj(const std::string& path, const std::string& base_dir, const LoadOptions& options) -> std::unique_ptr<Mesh>
+    {
+        u64 peak_before = peak_memory_usage();
+
+        auto parse_start = std::chrono::steady_clock::now();
+
+        std::vector<tinyobj::material_t> definitions;
+
+        ObjData obj = (options.importer == ObjImporter::Parallel)
+            ? parse_parallel(path, options.thread_count)
+            : parse_tinyobj(path, base_dir, definitions);
+
+        if (options.importer == ObjImporter::Parallel) {
+            definitions = load_material_libraries(obj, std::filesystem::path(path).parent_path());
+        }
+
+        std::chrono::duration<f64, std::milli> parse_time = std::chrono::steady_clock::now() - parse_start;
+
+        std::error_code ec;
+        f64 megabytes = static_cast<f64>(std::filesystem::file_size(path, ec)) / (1024.0 * 1024.0);
+
+        LoadLog::println(" - parsed {:.1f} MB in {:.2f} ms ({:.1f} MB/s, {})",
+            megabytes,
+            parse_time.count(),
+            megabytes / (parse_time.count() / 1000.0),
+            (options.importer == ObjImporter::Parallel) ? "parallel" : "tinyobj"
+        );
+
+        MeshData data = (options.dedup == VertexDedup::Streaming)
+            ? dedup_streaming(obj)
+            : dedup_expanded(obj);
+
+        data.materials = convert_materials(obj, definitions);
+        partition_clusters(data, options.cluster_triangles);
+        build_submeshes(data);
+        generate_lods(data, options.lod_count);
+
+        optimize_mesh(data);
+
+        auto mesh = std::make_unique<Mesh>();
+        mesh->layout = options.layout;
+        mesh->position_format = PositionFormat::Float32;
+        if (options.layout == VertexLayout::Compact) {
+            // compact positions are always 16 bit, fp32 falls back to snorm
+            mesh->position_format = (options.position_format == PositionFormat::Float16) ? PositionFormat::Float16 : PositionFormat::Snorm16;
+        }
+        mesh->bounds = compute_bounds(data);
+
+        if (options.layout == VertexLayout::Split) {
+            split_streams(data);
+        } else if (options.layout == VertexLayout::Compact) {
+            quantize_streams(data, *mesh);
+        }
+
+        mesh->index_type = narrow_indices(data, std::max({ data.vertices.size(), data.positions.size(), data.compact_positions.size() }));
+
+        // the dedup buffers are measured on their own above, this is the whole process and includes concurrent loads
+        LoadLog::println(" - process peak rss: {:.1f} MB -> {:.1f} MB",
+            static_cast<f64>(peak_before) / (1024.0 * 1024.0),
+            static_cast<f64>(peak_memory_usage()) / (1024.0 * 1024.0)
+        );
+
+        auto storage = std::make_shared<MeshData>(std::move(data));
+
+        mesh->vertices = storage->vertices;
+        mesh->positions = storage->positions;
+        mesh->attributes = storage->attributes;
+        mesh->compact_positions = storage->compact_positions;
+        mesh->compact_attributes = storage->compact_attributes;
+        mesh->submeshes = storage->submeshes;
+        mesh->materials = storage->materials;
+        mesh->lods = storage->lods;
+        mesh->clusters = storage->clusters;
+        mesh->indices = (mesh->index_type == IndexType::Uint16)
+            ? std::as_bytes(std::span(storage->short_indices))
+            : std::as_bytes(std::span(storage->indices));
+        mesh->storage = std::move(storage);
+
+        return mesh;
+    }
+
+}
+
+auto Loader::load_obj(const std::string& filename, const LoadOptions& options) -> Model
+{
+    LoadLog log;
+
+    LoadLog::println("loading {}", filename);
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::filesystem::path path = s_respath / filename;
+    std::string base_dir = std::filesystem::path(filename).parent_path().string();
+
+    u64 settings = import_settings(options);
+
+    std::unique_ptr<Mesh> mesh = options.use_cache ? MeshCache::load(path, settings) : nullptr;
+
+    bool cached = (mesh != nullptr);
+
+    if (!cached) {
+        mesh = import_obj(path.string(), base_dir, options);
+
+        if (options.use_cache) {
+            MeshCache::store(path, settings, *mesh);
+        }
+    }
+
+    std::chrono::duration<f64, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    LoadLog::println(" - vertices: {}", mesh->vertex_count());
+    LoadLog::println(" - triangles: {} ({} bit indices)", mesh->index_count() / 3, mesh->index_size() * 8);
+    LoadLog::println(" - submeshes: {} ({} need any-hit), {} lod levels", mesh->lod_submeshes(0).size(), std::ranges::count_if(mesh->lod_submeshes(0), [&](const Submesh& submesh) {
+        return !mesh->materials[submesh.material].opaque();
+    }), mesh->lods.size());
+    LoadLog::println(" - loaded {} in {:.2f} ms ({})", filename, elapsed.count(), cached ? "cache hit" : "cache miss");
 
     return Model { .mesh = std::move(mesh) };
 }
+
+auto Loader::evict_cache(const std::string& filename, const LoadOptions& options) -> bool
+{
+    return MeshCache::evict(s_respath / filename, import_settings(options));
+}
+
+LoadBatch::LoadBatch(std::span<const std::string> filenames, const LoadOptions& options)
+    : m_remaining(filenames.size())
+{
+    // every file parsing on all hardware threads at once would run files x threads workers
+    u32 budget = options.thread_count > 0 ? options.thread_count : std::max(1u, std::thread::hardware_concurrency());
+
+    LoadOptions share = options;
+    share.thread_count = std::max(1u, budget / static_cast<u32>(std::max<usize>(filenames.size(), 1)));
+
+    m_workers.reserve(filenames.size());
+    for (usize i = 0; i < filenames.size(); ++i) {
+        m_workers.emplace_back([this, i, filename = filenames[i], share] {
+            Model model = Loader::load_obj(filename, share);
+
+            {
+                std::scoped_lock lock(m_mutex);
+                m_ready.emplace_back(i, std::move(model));
+            }
+
+            m_done.notify_one();
+        });
+    }
+}
+
+auto LoadBatch::next() -> std::optional<std::pair<usize, Model>>
+{
+    std::unique_lock lock(m_mutex);
+    if (m_remaining == 0) {
+        return std::nullopt;
+    }
+
+    m_done.wait(lock, [this] { return !m_ready.empty(); });
+
+    auto result = std::move(m_ready.front());
+    m_ready.pop_front();
+    m_remaining--;
+
+    return result;
+}
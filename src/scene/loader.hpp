@@ -2,8 +2,73 @@
 
 #include "model.hpp"
 
+enum class ObjImporter
+{
+    TinyObj,
+    Parallel
+};
+
+enum class VertexDedup
+{
+    // expand every face corner, then meshopt_generateVertexRemap
+    Expanded,
+    // hash (position, normal, uv) index triples while walking the faces
+    Streaming
+};
+
+struct LoadOptions
+{
+    // reuse the optimized mesh from the on-disk cache when the source is unchanged
+    bool use_cache { true };
+
+    ObjImporter importer { ObjImporter::Parallel };
+
+    // worker threads for the parallel importer, 0 uses every hardware thread. a LoadBatch splits them across its files
+    u32 thread_count { 0 };
+
+    VertexDedup dedup { VertexDedup::Streaming };
+
+    VertexLayout layout { VertexLayout::Split };
+
+    // position encoding of the compact layout
+    PositionFormat position_format { PositionFormat::Snorm16 };
+
+    // levels including the full resolution mesh, 1 skips simplification
+    u32 lod_count { 1 };
+
+    // split meshes into spatial clusters of at most this many triangles, 0 keeps a single cluster
+    u32 cluster_triangles { 0 };
+};
+
 class Loader
 {
 public:
-    static auto load_obj(const std::string& filename) -> Model;
+    // prints what it did as one block once the model is ready
+    static auto load_obj(const std::string& filename, const LoadOptions& options = {}) -> Model;
+
+    // drops the cached mesh for these options, the next load_obj starts cold
+    static auto evict_cache(const std::string& filename, const LoadOptions& options = {}) -> bool;
+};
+
+// loads files concurrently, one worker thread each with an even share of the importer threads, and hands the
+// models out in the order they finish
+class LoadBatch
+{
+public:
+    LoadBatch(std::span<const std::string> filenames, const LoadOptions& options = {});
+
+    LoadBatch(const LoadBatch&) = delete;
+    LoadBatch& operator=(const LoadBatch&) = delete;
+
+    // blocks until another model is done and returns it with its index into filenames, nullopt once all were taken
+    auto next() -> std::optional<std::pair<usize, Model>>;
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_done;
+    std::deque<std::pair<usize, Model>> m_ready;
+    usize m_remaining { 0 };
+
+    // last, so the workers are joined before the queue they fill goes away
+    std::vector<std::jthread> m_workers;
 };
@@ -2,6 +2,8 @@
 
 #include <glm/glm.hpp>
 
+#include "quantization.hpp"
+
 struct Vertex
 {
     glm::vec3 position;
@@ -9,8 +11,235 @@ struct Vertex
     glm::vec2 uv;
 };
 
+struct VertexAttributes
+{
+    glm::vec3 normal;
+    glm::vec2 uv;
+};
+
+// 8 bytes, matches VK_FORMAT_R16G16B16A16_SNORM / _SFLOAT with w unused
+struct CompactPosition
+{
+    std::array<u16, 4> xyzw;
+};
+
+struct CompactAttributes
+{
+    std::array<i16, 2> normal; // octahedral, snorm16
+    std::array<u16, 2> uv;     // half
+};
+
+enum class VertexLayout : u32
+{
+    Interleaved,
+    // tightly packed positions for acceleration structure builds, normals and uvs in a second stream
+    Split,
+    // split streams quantized to 8 bytes each, positions relative to the mesh bounds
+    Compact
+};
+
+enum class PositionFormat : u32
+{
+    Float32,
+    Float16,
+    Snorm16
+};
+
+struct Material
+{
+    glm::vec3 diffuse { 0.8f };
+    f32 opacity { 1.0f };
+
+    // cut-out through map_d, hits have to be confirmed in any-hit
+    u32 alpha_tested { 0 };
+
+    [[nodiscard]] auto opaque() const -> bool { return alpha_tested == 0 && opacity >= 1.0f; }
+};
+
+// a run of triangles sharing one material, built as its own BLAS geometry
+struct Submesh
+{
+    u32 index_offset;
+    u32 index_count;
+    u32 material;
+
+    // spatial cluster the triangles belong to, every cluster becomes its own BLAS
+    u32 cluster;
+};
+
+// a simplified copy of every submesh, all levels index the same vertex streams
+struct Lod
+{
+    u32 submesh_offset;
+    u32 submesh_count;
+
+    // worst deviation from the full resolution surface, in mesh units
+    f32 error;
+};
+
+enum class IndexType : u32
+{
+    Uint16,
+    Uint32
+};
+
+struct Bounds
+{
+    glm::vec3 min { std::numeric_limits<f32>::max() };
+    glm::vec3 max { std::numeric_limits<f32>::lowest() };
+
+    [[nodiscard]] auto center() const -> glm::vec3 { return (min + max) * 0.5f; }
+    [[nodiscard]] auto extent() const -> glm::vec3 { return (max - min) * 0.5f; }
+
+    [[nodiscard]] auto surface_area() const -> f32
+    {
+        glm::vec3 size = glm::max(max - min, glm::vec3(0.0f));
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    auto expand(const glm::vec3& point) -> void
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    auto expand(const Bounds& other) -> void
+    {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+};
+
 struct Mesh
 {
-    std::vector<Vertex> vertices;
-    std::vector<u32> indices;
+    VertexLayout layout { VertexLayout::Interleaved };
+    PositionFormat position_format { PositionFormat::Float32 };
+
+    Bounds bounds;
+
+    std::span<const Vertex> vertices;
+
+    std::span<const glm::vec3> positions;
+    std::span<const VertexAttributes> attributes;
+
+    std::span<const CompactPosition> compact_positions;
+    std::span<const CompactAttributes> compact_attributes;
+
+    std::span<const Submesh> submeshes;
+    std::span<const Material> materials;
+
+    // level 0 is the full resolution mesh and covers the leading submeshes
+    std::span<const Lod> lods;
+
+    // bounds of every spatial cluster, submeshes of a level are sorted by cluster
+    std::span<const Bounds> clusters;
+
+    // u16 when every vertex is addressable with 16 bits, u32 otherwise
+    IndexType index_type { IndexType::Uint32 };
+    std::span<const std::byte> indices;
+
+    // keeps the spans alive: heap arrays after a fresh import, a mapped cache file on a warm start
+    std::shared_ptr<const void> storage;
+
+    [[nodiscard]] auto vertex_count() const -> usize
+    {
+        switch (layout) {
+            case VertexLayout::Split: return positions.size();
+            case VertexLayout::Compact: return compact_positions.size();
+            default: return vertices.size();
+        }
+    }
+
+    [[nodiscard]] auto lod_submeshes(usize level) const -> std::span<const Submesh>
+    {
+        return submeshes.subspan(lods[level].submesh_offset, lods[level].submesh_count);
+    }
+
+    [[nodiscard]] auto lod_submeshes(usize level, u32 cluster) const -> std::span<const Submesh>
+    {
+        auto submeshes = lod_submeshes(level);
+        auto range = std::ranges::equal_range(submeshes, cluster, {}, &Submesh::cluster);
+
+        return std::span(range.begin(), range.end());
+    }
+
+    // coarsest level whose error stays under max_error once projected, pixels_per_unit is the screen size of one unit at distance 1
+    [[nodiscard]] auto select_lod(f32 distance, f32 pixels_per_unit, f32 max_error = 1.0f) const -> u32
+    {
+        u32 level = 0;
+        for (u32 i = 1; i < lods.size(); ++i) {
+            if (lods[i].error * pixels_per_unit > max_error * distance) break;
+            level = i;
+        }
+
+        return level;
+    }
+
+    [[nodiscard]] auto index_size() const -> usize
+    {
+        return (index_type == IndexType::Uint16) ? sizeof(u16) : sizeof(u32);
+    }
+
+    [[nodiscard]] auto index_count() const -> usize
+    {
+        return indices.size() / index_size();
+    }
+
+    [[nodiscard]] auto index(usize i) const -> u32
+    {
+        if (index_type == IndexType::Uint16) {
+            u16 value;
+            std::memcpy(&value, indices.data() + i * sizeof(u16), sizeof(u16));
+            return value;
+        }
+
+        u32 value;
+        std::memcpy(&value, indices.data() + i * sizeof(u32), sizeof(u32));
+        return value;
+    }
+
+    // scale and offset that take compact positions from [-1, 1] back into mesh space
+    [[nodiscard]] auto dequantize_scale() const -> glm::vec3
+    {
+        glm::vec3 extent = bounds.extent();
+        return glm::vec3(
+            extent.x > 0.0f ? extent.x : 1.0f,
+            extent.y > 0.0f ? extent.y : 1.0f,
+            extent.z > 0.0f ? extent.z : 1.0f
+        );
+    }
+
+    [[nodiscard]] auto dequantize_offset() const -> glm::vec3
+    {
+        return bounds.center();
+    }
+
+    [[nodiscard]] auto dequantize_transform() const -> glm::mat4
+    {
+        glm::vec3 scale = dequantize_scale();
+        glm::vec3 offset = dequantize_offset();
+
+        glm::mat4 transform(1.0f);
+        transform[0][0] = scale.x;
+        transform[1][1] = scale.y;
+        transform[2][2] = scale.z;
+        transform[3] = glm::vec4(offset, 1.0f);
+
+        return transform;
+    }
+
+    [[nodiscard]] auto position(usize index) const -> glm::vec3
+    {
+        switch (layout) {
+            case VertexLayout::Split: return positions[index];
+            case VertexLayout::Compact: {
+                const auto& q = compact_positions[index].xyzw;
+                glm::vec3 p = (position_format == PositionFormat::Float16)
+                    ? glm::vec3(Quantization::half_to_float(q[0]), Quantization::half_to_float(q[1]), Quantization::half_to_float(q[2]))
+                    : glm::vec3(Quantization::snorm16_to_float(static_cast<i16>(q[0])), Quantization::snorm16_to_float(static_cast<i16>(q[1])), Quantization::snorm16_to_float(static_cast<i16>(q[2])));
+                return dequantize_offset() + p * dequantize_scale();
+            }
+            default: return vertices[index].position;
+        }
+    }
 };
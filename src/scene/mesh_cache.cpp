@@ -0,0 +1,411 @@
+#include "mesh_cache.hpp"
+#include "load_log.hpp"
+
+#include "platform/mapped_file.hpp"
+
+#include <meshoptimizer.h>
+
+#include <pathconfig.inl>
+
+namespace {
+
+    std::filesystem::path s_cachepath(PathConfig::cache_dir);
+
+    constexpr u32 s_magic = 0x4D585452; // "RTXM"
+    constexpr u32 s_version = 7;
+    constexpr u64 s_alignment = 16;
+
+    enum class SectionKind : u32
+    {
+        Vertices = 1,
+        EncodedIndices = 2,
+        Positions = 3,
+        Attributes = 4,
+        CompactPositions = 5,
+        CompactAttributes = 6,
+        Info = 7,
+        Submeshes = 8,
+        Materials = 9,
+        Lods = 10,
+        Clusters = 11
+    };
+
+    struct MeshInfo
+    {
+        Bounds bounds;
+        VertexLayout layout;
+        PositionFormat position_format;
+        IndexType index_type;
+        u32 index_count;
+    };
+
+    // vertex streams stay in the mapping, indices are decoded from the codec stream into the heap
+    struct CachedMesh
+    {
+        std::shared_ptr<MappedFile> file;
+        std::vector<std::byte> indices;
+    };
+
+    struct Header
+    {
+        u32 magic;
+        u32 version;
+        u64 source_time;
+        u64 source_size;
+        u64 source_hash;
+        u64 settings;
+        u32 section_count;
+        u32 reserved;
+    };
+
+    struct Section
+    {
+        SectionKind kind;
+        u32 stride;
+        u64 offset;
+        u64 size;
+    };
+
+    struct SourceKey
+    {
+        u64 time;
+        u64 size;
+    };
+
+    constexpr auto align_up(u64 size) -> u64
+    {
+        return (size + s_alignment - 1) & ~(s_alignment - 1);
+    }
+
+    auto hash_bytes(std::span<const std::byte> bytes) -> u64
+    {
+        constexpr u64 prime = 0x9E3779B97F4A7C15ull;
+
+        u64 hash = bytes.size() * prime;
+
+        usize i = 0;
+        for (; i + sizeof(u64) <= bytes.size(); i += sizeof(u64)) {
+            u64 word;
+            std::memcpy(&word, bytes.data() + i, sizeof(u64));
+            hash = (std::rotl(hash, 27) ^ (word * prime)) * 0xC2B2AE3D27D4EB4Full;
+        }
+
+        for (; i < bytes.size(); ++i) {
+            hash = (hash ^ static_cast<u64>(bytes[i])) * prime;
+        }
+
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 33;
+        hash *= 0xC4CEB9FE1A85EC53ull;
+        hash ^= hash >> 33;
+
+        return hash;
+    }
+
+    auto source_key(const std::filesystem::path& source) -> std::optional<SourceKey>
+    {
+        std::error_code ec;
+
+        auto time = std::filesystem::last_write_time(source, ec);
+        if (ec) return std::nullopt;
+
+        auto size = std::filesystem::file_size(source, ec);
+        if (ec) return std::nullopt;
+
+        return SourceKey {
+            .time = static_cast<u64>(time.time_since_epoch().count()),
+            .size = static_cast<u64>(size)
+        };
+    }
+
+    // one file per source and settings, so runs importing the same model with different options do not evict each other
+    auto cache_file(const std::filesystem::path& source, u64 settings) -> std::filesystem::path
+    {
+        std::string key = source.generic_string();
+        u64 key_hash = hash_bytes(std::as_bytes(std::span(key)));
+
+        return s_cachepath / std::format("{}-{:016x}-{:016x}.mesh", source.stem().string(), key_hash, settings);
+    }
+
+}
+
+auto MeshCache::load(const std::filesystem::path& source, u64 settings) -> std::unique_ptr<Mesh>
+{
+    auto path = cache_file(source, settings);
+
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec)) {
+        return nullptr;
+    }
+
+    auto file = std::make_shared<MappedFile>(path);
+    if (!file->valid() || file->size() < sizeof(Header)) {
+        return nullptr;
+    }
+
+    Header header;
+    std::memcpy(&header, file->data(), sizeof(Header));
+
+    if (header.magic != s_magic || header.version != s_version) {
+        LoadLog::println(" - mesh cache: {} has an outdated format", path.filename().string());
+        return nullptr;
+    }
+
+    if (header.settings != settings) {
+        LoadLog::println(" - mesh cache: {} was built with different import options", path.filename().string());
+        return nullptr;
+    }
+
+    auto key = source_key(source);
+    if (!key.has_value() || key->size != header.source_size) {
+        return nullptr;
+    }
+
+    if (key->time != header.source_time) {
+        MappedFile contents(source);
+        if (!contents.valid() || hash_bytes(contents.bytes()) != header.source_hash) {
+            return nullptr;
+        }
+
+        LoadLog::println(" - mesh cache: source was touched but contents are unchanged");
+    }
+
+    u64 table_end = sizeof(Header) + static_cast<u64>(header.section_count) * sizeof(Section);
+    if (table_end > file->size()) {
+        return nullptr;
+    }
+
+    auto mesh = std::make_unique<Mesh>();
+
+    std::span<const std::byte> encoded_indices;
+    u32 index_count = 0;
+
+    for (u32 i = 0; i < header.section_count; ++i) {
+        Section section;
+        std::memcpy(&section, file->data() + sizeof(Header) + i * sizeof(Section), sizeof(Section));
+
+        if (section.offset + section.size > file->size() || section.stride == 0 || section.size % section.stride != 0) {
+            return nullptr;
+        }
+
+        const std::byte* data = file->data() + section.offset;
+        usize count = section.size / section.stride;
+
+        switch (section.kind) {
+            case SectionKind::Vertices: {
+                if (section.stride != sizeof(Vertex)) return nullptr;
+                mesh->vertices = std::span(reinterpret_cast<const Vertex*>(data), count);
+            } break;
+            case SectionKind::Positions: {
+                if (section.stride != sizeof(glm::vec3)) return nullptr;
+                mesh->positions = std::span(reinterpret_cast<const glm::vec3*>(data), count);
+            } break;
+            case SectionKind::Attributes: {
+                if (section.stride != sizeof(VertexAttributes)) return nullptr;
+                mesh->attributes = std::span(reinterpret_cast<const VertexAttributes*>(data), count);
+            } break;
+            case SectionKind::CompactPositions: {
+                if (section.stride != sizeof(CompactPosition)) return nullptr;
+                mesh->compact_positions = std::span(reinterpret_cast<const CompactPosition*>(data), count);
+            } break;
+            case SectionKind::CompactAttributes: {
+                if (section.stride != sizeof(CompactAttributes)) return nullptr;
+                mesh->compact_attributes = std::span(reinterpret_cast<const CompactAttributes*>(data), count);
+            } break;
+            case SectionKind::Info: {
+                if (section.stride != sizeof(MeshInfo) || count != 1) return nullptr;
+
+                MeshInfo info;
+                std::memcpy(&info, data, sizeof(MeshInfo));
+
+                mesh->bounds = info.bounds;
+                mesh->layout = info.layout;
+                mesh->position_format = info.position_format;
+                mesh->index_type = info.index_type;
+                index_count = info.index_count;
+            } break;
+            case SectionKind::Submeshes: {
+                if (section.stride != sizeof(Submesh)) return nullptr;
+                mesh->submeshes = std::span(reinterpret_cast<const Submesh*>(data), count);
+            } break;
+            case SectionKind::Materials: {
+                if (section.stride != sizeof(Material)) return nullptr;
+                mesh->materials = std::span(reinterpret_cast<const Material*>(data), count);
+            } break;
+            case SectionKind::Lods: {
+                if (section.stride != sizeof(Lod)) return nullptr;
+                mesh->lods = std::span(reinterpret_cast<const Lod*>(data), count);
+            } break;
+            case SectionKind::Clusters: {
+                if (section.stride != sizeof(Bounds)) return nullptr;
+                mesh->clusters = std::span(reinterpret_cast<const Bounds*>(data), count);
+            } break;
+            case SectionKind::EncodedIndices: {
+                if (section.stride != 1) return nullptr;
+                encoded_indices = std::span(data, count);
+            } break;
+            default:
+                break;
+        }
+    }
+
+    bool complete = false;
+    switch (mesh->layout) {
+        case VertexLayout::Interleaved: complete = !mesh->vertices.empty(); break;
+        case VertexLayout::Split: complete = !mesh->positions.empty() && mesh->attributes.size() == mesh->positions.size(); break;
+        case VertexLayout::Compact: complete = !mesh->compact_positions.empty() && mesh->compact_attributes.size() == mesh->compact_positions.size(); break;
+    }
+
+    if (!complete || encoded_indices.empty() || index_count == 0 || mesh->submeshes.empty() || mesh->lods.empty() || mesh->clusters.empty()) {
+        return nullptr;
+    }
+
+    for (const auto& submesh : mesh->submeshes) {
+        if (static_cast<u64>(submesh.index_offset) + submesh.index_count > index_count || submesh.material >= mesh->materials.size() || submesh.cluster >= mesh->clusters.size()) {
+            return nullptr;
+        }
+    }
+
+    for (const auto& lod : mesh->lods) {
+        if (static_cast<u64>(lod.submesh_offset) + lod.submesh_count > mesh->submeshes.size()) {
+            return nullptr;
+        }
+    }
+
+    auto storage = std::make_shared<CachedMesh>();
+    storage->file = std::move(file);
+    storage->indices.resize(index_count * mesh->index_size());
+
+    if (meshopt_decodeIndexBuffer(storage->indices.data(), index_count, mesh->index_size(), reinterpret_cast<const unsigned char*>(encoded_indices.data()), encoded_indices.size()) != 0) {
+        std::println(std::cerr, "mesh cache: corrupt index stream in {}", path.filename().string());
+        return nullptr;
+    }
+
+    mesh->indices = storage->indices;
+    mesh->storage = std::move(storage);
+
+    return mesh;
+}
+
+auto MeshCache::store(const std::filesystem::path& source, u64 settings, const Mesh& mesh) -> void
+{
+    auto key = source_key(source);
+    MappedFile contents(source);
+
+    if (!key.has_value() || !contents.valid()) {
+        return;
+    }
+
+    std::vector<Section> sections;
+    std::vector<std::span<const std::byte>> payloads;
+
+    auto add_section = [&]<typename T>(SectionKind kind, std::span<const T> data) {
+        sections.push_back(Section { .kind = kind, .stride = sizeof(T), .offset = 0, .size = data.size_bytes() });
+        payloads.push_back(std::as_bytes(data));
+    };
+
+    MeshInfo info {
+        .bounds = mesh.bounds,
+        .layout = mesh.layout,
+        .position_format = mesh.position_format,
+        .index_type = mesh.index_type,
+        .index_count = static_cast<u32>(mesh.index_count())
+    };
+
+    add_section(SectionKind::Info, std::span<const MeshInfo>(&info, 1));
+
+    switch (mesh.layout) {
+        case VertexLayout::Interleaved: {
+            add_section(SectionKind::Vertices, mesh.vertices);
+        } break;
+        case VertexLayout::Split: {
+            add_section(SectionKind::Positions, mesh.positions);
+            add_section(SectionKind::Attributes, mesh.attributes);
+        } break;
+        case VertexLayout::Compact: {
+            add_section(SectionKind::CompactPositions, mesh.compact_positions);
+            add_section(SectionKind::CompactAttributes, mesh.compact_attributes);
+        } break;
+    }
+
+    // the codec wants 32 bit input regardless of the width the mesh is stored with
+    std::vector<u32> indices(mesh.index_count());
+    for (usize i = 0; i < indices.size(); ++i) {
+        indices[i] = mesh.index(i);
+    }
+
+    std::vector<unsigned char> encoded(meshopt_encodeIndexBufferBound(indices.size(), mesh.vertex_count()));
+    encoded.resize(meshopt_encodeIndexBuffer(encoded.data(), encoded.size(), indices.data(), indices.size()));
+
+    if (encoded.empty()) {
+        std::println(std::cerr, "mesh cache: failed to encode indices of {}", source.filename().string());
+        return;
+    }
+
+    add_section(SectionKind::EncodedIndices, std::span<const unsigned char>(encoded));
+    add_section(SectionKind::Submeshes, mesh.submeshes);
+    add_section(SectionKind::Materials, mesh.materials);
+    add_section(SectionKind::Lods, mesh.lods);
+    add_section(SectionKind::Clusters, mesh.clusters);
+
+    u64 offset = align_up(sizeof(Header) + sections.size() * sizeof(Section));
+    for (auto& section : sections) {
+        section.offset = offset;
+        offset = align_up(offset + section.size);
+    }
+
+    Header header {
+        .magic = s_magic,
+        .version = s_version,
+        .source_time = key->time,
+        .source_size = key->size,
+        .source_hash = hash_bytes(contents.bytes()),
+        .settings = settings,
+        .section_count = static_cast<u32>(sections.size()),
+        .reserved = 0
+    };
+
+    std::error_code ec;
+    std::filesystem::create_directories(s_cachepath, ec);
+
+    auto path = cache_file(source, settings);
+    auto temp = std::filesystem::path(path).concat(".tmp");
+
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::println(std::cerr, "mesh cache: failed to open {}", temp.string());
+            return;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        file.write(reinterpret_cast<const char*>(sections.data()), sections.size() * sizeof(Section));
+
+        for (usize i = 0; i < sections.size(); ++i) {
+            std::vector<char> padding(sections[i].offset - static_cast<u64>(file.tellp()), 0);
+            file.write(padding.data(), padding.size());
+            file.write(reinterpret_cast<const char*>(payloads[i].data()), payloads[i].size());
+        }
+
+        if (!file.good()) {
+            std::println(std::cerr, "mesh cache: failed to write {}", temp.string());
+            return;
+        }
+    }
+
+    std::filesystem::rename(temp, path, ec);
+    if (ec) {
+        std::println(std::cerr, "mesh cache: failed to replace {}: {}", path.string(), ec.message());
+        std::filesystem::remove(temp, ec);
+        return;
+    }
+
+    LoadLog::println(" - mesh cache: wrote {} ({} bytes, indices {} -> {} bytes)", path.filename().string(), offset, mesh.indices.size(), encoded.size());
+}
+
+auto MeshCache::evict(const std::filesystem::path& source, u64 settings) -> bool
+{
+    std::error_code ec;
+    return std::filesystem::remove(cache_file(source, settings), ec);
+}
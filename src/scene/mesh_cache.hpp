@@ -0,0 +1,13 @@
+#pragma once
+
+#include "mesh.hpp"
+
+class MeshCache
+{
+public:
+    // settings is a caller defined key for the import options, a mesh built with other settings is a miss
+    static auto load(const std::filesystem::path& source, u64 settings) -> std::unique_ptr<Mesh>;
+    static auto store(const std::filesystem::path& source, u64 settings, const Mesh& mesh) -> void;
+    // removes the cached mesh so the next load imports the source again, false when there was none
+    static auto evict(const std::filesystem::path& source, u64 settings) -> bool;
+};
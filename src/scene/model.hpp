@@ -4,6 +4,6 @@
 
 struct Model
 {
+    // submeshes and materials live in the mesh so the cache can serve them with the geometry
     std::unique_ptr<Mesh> mesh;
-    // TODO: material
 };
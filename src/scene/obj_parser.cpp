@@ -0,0 +1,403 @@
+#include "obj_parser.hpp"
+
+#include "platform/parallel.hpp"
+
+namespace {
+
+    constexpr usize s_min_chunk_size = 1 << 20;
+
+    struct Fixup
+    {
+        u32 corner;
+        u32 component;
+    };
+
+    struct Chunk
+    {
+        std::string_view text;
+
+        std::vector<f32> positions;
+        std::vector<f32> normals;
+        std::vector<f32> texcoords;
+
+        std::vector<ObjIndex> corners;
+        std::vector<u32> face_sizes;
+
+        // usemtl names in order of appearance, faces refer to them by local index
+        // and -1 marks faces that inherit the material active at the chunk start
+        std::vector<std::string_view> material_names;
+        std::vector<i32> face_materials;
+        i32 material { -1 };
+
+        std::vector<std::string_view> material_libraries;
+
+        // negative (relative) indices are resolved against the chunk start and patched once the global counts are known
+        std::vector<Fixup> fixups;
+    };
+
+    inline auto is_space(char c) -> bool
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    inline auto skip_space(const char* p, const char* end) -> const char*
+    {
+        while (p < end && is_space(*p)) ++p;
+        return p;
+    }
+
+    inline auto parse_float(const char*& p, const char* end) -> f32
+    {
+        p = skip_space(p, end);
+        if (p < end && *p == '+') ++p;
+
+        f32 value = 0.0f;
+        auto [next, ec] = std::from_chars(p, end, value);
+        p = (ec == std::errc()) ? next : p;
+
+        return value;
+    }
+
+    inline auto parse_int(const char*& p, const char* end, i32& value) -> bool
+    {
+        if (p < end && *p == '+') ++p;
+
+        auto [next, ec] = std::from_chars(p, end, value);
+        if (ec != std::errc()) return false;
+
+        p = next;
+        return true;
+    }
+
+    inline auto parse_name(const char* p, const char* end) -> std::string_view
+    {
+        p = skip_space(p, end);
+        while (end > p && is_space(end[-1])) --end;
+
+        return std::string_view(p, static_cast<usize>(end - p));
+    }
+
+    inline auto starts_with_keyword(const char* p, const char* end, std::string_view keyword) -> bool
+    {
+        usize length = keyword.size();
+        return static_cast<usize>(end - p) > length && std::string_view(p, length) == keyword && is_space(p[length]);
+    }
+
+    auto parse_chunk(Chunk& chunk) -> void
+    {
+        const char* p = chunk.text.data();
+        const char* end = p + chunk.text.size();
+
+        while (p < end) {
+            const char* line_end = static_cast<const char*>(std::memchr(p, '\n', static_cast<usize>(end - p)));
+            if (line_end == nullptr) line_end = end;
+
+            p = skip_space(p, line_end);
+
+            if (line_end - p >= 2 && p[0] == 'v' && is_space(p[1])) {
+                p += 1;
+                chunk.positions.push_back(parse_float(p, line_end));
+                chunk.positions.push_back(parse_float(p, line_end));
+                chunk.positions.push_back(parse_float(p, line_end));
+            } else if (line_end - p >= 3 && p[0] == 'v' && p[1] == 'n' && is_space(p[2])) {
+                p += 2;
+                chunk.normals.push_back(parse_float(p, line_end));
+                chunk.normals.push_back(parse_float(p, line_end));
+                chunk.normals.push_back(parse_float(p, line_end));
+            } else if (line_end - p >= 3 && p[0] == 'v' && p[1] == 't' && is_space(p[2])) {
+                p += 2;
+                chunk.texcoords.push_back(parse_float(p, line_end));
+                chunk.texcoords.push_back(parse_float(p, line_end));
+            } else if (line_end - p >= 2 && p[0] == 'f' && is_space(p[1])) {
+                p += 1;
+
+                const std::array<usize, 3> counts {
+                    chunk.positions.size() / 3,
+                    chunk.normals.size() / 3,
+                    chunk.texcoords.size() / 2
+                };
+
+                u32 face_size = 0;
+
+                while (true) {
+                    p = skip_space(p, line_end);
+                    if (p >= line_end) break;
+
+                    std::array<i32, 3> raw { 0, 0, 0 }; // position, uv, normal as written in the file
+
+                    if (!parse_int(p, line_end, raw[0])) break;
+
+                    if (p < line_end && *p == '/') {
+                        ++p;
+                        if (p < line_end && *p != '/') {
+                            parse_int(p, line_end, raw[1]);
+                        }
+                        if (p < line_end && *p == '/') {
+                            ++p;
+                            parse_int(p, line_end, raw[2]);
+                        }
+                    }
+
+                    u32 corner = static_cast<u32>(chunk.corners.size());
+
+                    auto resolve = [&](i32 value, u32 component, usize count) -> i32 {
+                        if (value > 0) return value - 1;
+                        if (value == 0) return -1;
+
+                        chunk.fixups.push_back(Fixup { .corner = corner, .component = component });
+                        return static_cast<i32>(count) + value;
+                    };
+
+                    chunk.corners.push_back(ObjIndex {
+                        .position = resolve(raw[0], 0, counts[0]),
+                        .normal = resolve(raw[2], 1, counts[1]),
+                        .uv = resolve(raw[1], 2, counts[2])
+                    });
+
+                    face_size++;
+
+                    while (p < line_end && !is_space(*p)) ++p;
+                }
+
+                chunk.face_sizes.push_back(face_size);
+                chunk.face_materials.push_back(chunk.material);
+            } else if (starts_with_keyword(p, line_end, "usemtl")) {
+                std::string_view name = parse_name(p + 6, line_end);
+
+                auto it = std::ranges::find(chunk.material_names, name);
+                chunk.material = static_cast<i32>(std::distance(chunk.material_names.begin(), it));
+
+                if (it == chunk.material_names.end()) {
+                    chunk.material_names.push_back(name);
+                }
+            } else if (starts_with_keyword(p, line_end, "mtllib")) {
+                chunk.material_libraries.push_back(parse_name(p + 6, line_end));
+            }
+
+            p = line_end + 1;
+        }
+    }
+
+    auto split_chunks(std::string_view text, u32 thread_count) -> std::vector<Chunk>
+    {
+        usize count = std::clamp<usize>(text.size() / s_min_chunk_size, 1, thread_count);
+        usize target = text.size() / count;
+
+        std::vector<Chunk> chunks;
+        chunks.reserve(count);
+
+        usize begin = 0;
+        for (usize i = 0; i < count && begin < text.size(); ++i) {
+            usize end = (i + 1 == count) ? text.size() : std::max(begin, target * (i + 1));
+
+            if (end < text.size()) {
+                usize newline = text.find('\n', end);
+                end = (newline == std::string_view::npos) ? text.size() : newline + 1;
+            }
+
+            chunks.emplace_back().text = text.substr(begin, end - begin);
+            begin = end;
+        }
+
+        return chunks;
+    }
+
+    auto position_at(const std::vector<f32>& positions, i32 index) -> std::array<f32, 3>
+    {
+        return { positions[3 * index + 0], positions[3 * index + 1], positions[3 * index + 2] };
+    }
+
+    auto distance_squared(const std::array<f32, 3>& a, const std::array<f32, 3>& b) -> f32
+    {
+        f32 x = b[0] - a[0];
+        f32 y = b[1] - a[1];
+        f32 z = b[2] - a[2];
+        return x * x + y * y + z * z;
+    }
+
+}
+
+auto ObjParser::parse(std::span<const std::byte> bytes, u32 thread_count) -> ObjData
+{
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::string_view text(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+
+    auto chunks = split_chunks(text, thread_count);
+
+    parallel_for(chunks.size(), [&](usize i) {
+        parse_chunk(chunks[i]);
+    });
+
+    // global attribute bases of every chunk
+
+    struct Base
+    {
+        usize positions { 0 };
+        usize normals { 0 };
+        usize texcoords { 0 };
+        usize triangles { 0 };
+    };
+
+    std::vector<Base> bases(chunks.size() + 1);
+
+    for (usize i = 0; i < chunks.size(); ++i) {
+        usize triangles = 0;
+        for (u32 face_size : chunks[i].face_sizes) {
+            if (face_size >= 3) triangles += face_size - 2;
+        }
+
+        bases[i + 1] = Base {
+            .positions = bases[i].positions + chunks[i].positions.size(),
+            .normals = bases[i].normals + chunks[i].normals.size(),
+            .texcoords = bases[i].texcoords + chunks[i].texcoords.size(),
+            .triangles = bases[i].triangles + triangles
+        };
+    }
+
+    // material names are global in first-use order, each chunk starts with whatever the previous one left active
+
+    ObjData data;
+
+    std::vector<std::vector<i32>> material_ids(chunks.size());
+    std::vector<i32> inherited_materials(chunks.size(), -1);
+
+    i32 active_material = -1;
+    for (usize i = 0; i < chunks.size(); ++i) {
+        const auto& chunk = chunks[i];
+
+        for (auto name : chunk.material_names) {
+            auto it = std::ranges::find(data.material_names, name);
+            material_ids[i].push_back(static_cast<i32>(std::distance(data.material_names.begin(), it)));
+
+            if (it == data.material_names.end()) {
+                data.material_names.emplace_back(name);
+            }
+        }
+
+        for (auto library : chunk.material_libraries) {
+            data.material_libraries.emplace_back(library);
+        }
+
+        inherited_materials[i] = active_material;
+        if (chunk.material >= 0) {
+            active_material = material_ids[i][chunk.material];
+        }
+    }
+
+    data.positions.resize(bases.back().positions);
+    data.normals.resize(bases.back().normals);
+    data.texcoords.resize(bases.back().texcoords);
+    data.indices.resize(bases.back().triangles * 3);
+    data.materials.resize(bases.back().triangles);
+
+    // normal and uv references past the end are dropped to -1 like absent ones, the corner keeps its position
+
+    const i32 normal_count = static_cast<i32>(data.normals.size() / 3);
+    const i32 texcoord_count = static_cast<i32>(data.texcoords.size() / 2);
+
+    std::vector<usize> cleared(chunks.size(), 0);
+
+    parallel_for(chunks.size(), [&](usize i) {
+        auto& chunk = chunks[i];
+        const auto& base = bases[i];
+
+        std::ranges::copy(chunk.positions, data.positions.begin() + base.positions);
+        std::ranges::copy(chunk.normals, data.normals.begin() + base.normals);
+        std::ranges::copy(chunk.texcoords, data.texcoords.begin() + base.texcoords);
+
+        for (const auto& fixup : chunk.fixups) {
+            auto& corner = chunk.corners[fixup.corner];
+            switch (fixup.component) {
+                case 0: corner.position += static_cast<i32>(base.positions / 3); break;
+                case 1: corner.normal += static_cast<i32>(base.normals / 3); break;
+                case 2: corner.uv += static_cast<i32>(base.texcoords / 2); break;
+            }
+        }
+
+        for (auto& corner : chunk.corners) {
+            if (corner.normal >= normal_count || corner.normal < -1) {
+                corner.normal = -1;
+                cleared[i]++;
+            }
+
+            if (corner.uv >= texcoord_count || corner.uv < -1) {
+                corner.uv = -1;
+                cleared[i]++;
+            }
+        }
+    });
+
+    usize invalid_attributes = std::accumulate(cleared.begin(), cleared.end(), usize { 0 });
+    if (invalid_attributes > 0) {
+        std::println(std::cerr, "ObjParser: dropped {} references to missing normals or texcoords", invalid_attributes);
+    }
+
+    // triangulate once every position is in place, quads need them to pick a diagonal
+
+    std::vector<usize> dropped(chunks.size(), 0);
+
+    parallel_for(chunks.size(), [&](usize i) {
+        const auto& chunk = chunks[i];
+        const i32 position_count = static_cast<i32>(data.positions.size() / 3);
+
+        ObjIndex* out = data.indices.data() + bases[i].triangles * 3;
+        i32* out_material = data.materials.data() + bases[i].triangles;
+        usize corner = 0;
+
+        for (usize f = 0; f < chunk.face_sizes.size(); ++f) {
+            u32 face_size = chunk.face_sizes[f];
+            const ObjIndex* face = chunk.corners.data() + corner;
+            corner += face_size;
+
+            if (face_size < 3) {
+                continue;
+            }
+
+            i32 local_material = chunk.face_materials[f];
+            out_material = std::fill_n(out_material, face_size - 2, (local_material >= 0) ? material_ids[i][local_material] : inherited_materials[i]);
+
+            bool valid = std::all_of(face, face + face_size, [&](const ObjIndex& idx) {
+                return idx.position >= 0 && idx.position < position_count;
+            });
+
+            if (!valid) {
+                // keep the output layout, consumers skip triangles without a position
+                out = std::fill_n(out, (face_size - 2) * 3, ObjIndex { -1, -1, -1 });
+                dropped[i]++;
+                continue;
+            }
+
+            if (face_size == 4) {
+                // same split as tinyobj: cut along the shorter diagonal
+                f32 d02 = distance_squared(position_at(data.positions, face[0].position), position_at(data.positions, face[2].position));
+                f32 d13 = distance_squared(position_at(data.positions, face[1].position), position_at(data.positions, face[3].position));
+
+                if (d02 < d13) {
+                    *out++ = face[0]; *out++ = face[1]; *out++ = face[2];
+                    *out++ = face[0]; *out++ = face[2]; *out++ = face[3];
+                } else {
+                    *out++ = face[0]; *out++ = face[1]; *out++ = face[3];
+                    *out++ = face[1]; *out++ = face[2]; *out++ = face[3];
+                }
+
+                continue;
+            }
+
+            for (u32 t = 1; t + 1 < face_size; ++t) {
+                *out++ = face[0];
+                *out++ = face[t];
+                *out++ = face[t + 1];
+            }
+        }
+    });
+
+    usize invalid = std::accumulate(dropped.begin(), dropped.end(), usize { 0 });
+    if (invalid > 0) {
+        std::println(std::cerr, "ObjParser: {} faces reference missing positions", invalid);
+    }
+
+    return data;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+struct ObjIndex
+{
+    i32 position;
+    i32 normal;
+    i32 uv;
+};
+
+struct ObjData
+{
+    std::vector<f32> positions;
+    std::vector<f32> normals;
+    std::vector<f32> texcoords;
+
+    // triangulated face corners in file order, -1 marks a missing attribute
+    // and triangles of malformed faces carry no position at all
+    std::vector<ObjIndex> indices;
+
+    // usemtl state of every triangle as an index into material_names, -1 before the first usemtl
+    std::vector<i32> materials;
+    std::vector<std::string> material_names;
+
+    // mtllib references in file order, relative to the obj
+    std::vector<std::string> material_libraries;
+};
+
+class ObjParser
+{
+public:
+    static auto parse(std::span<const std::byte> text, u32 thread_count = 0) -> ObjData;
+};
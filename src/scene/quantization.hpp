@@ -0,0 +1,107 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace Quantization {
+
+    inline auto float_to_half(f32 value) -> u16
+    {
+        u32 bits = std::bit_cast<u32>(value);
+        u32 sign = (bits >> 16) & 0x8000;
+        u32 biased = (bits >> 23) & 0xFF;
+        u32 mantissa = bits & 0x7FFFFF;
+
+        if (biased == 0xFF) {
+            return static_cast<u16>(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+        }
+
+        i32 exponent = static_cast<i32>(biased) - 127 + 15;
+
+        if (exponent >= 31) {
+            return static_cast<u16>(sign | 0x7C00);
+        }
+
+        if (exponent <= 0) {
+            if (exponent < -10) return static_cast<u16>(sign);
+
+            mantissa |= 0x800000;
+
+            u32 shift = static_cast<u32>(14 - exponent);
+            u32 half = mantissa >> shift;
+            u32 rest = mantissa & ((1u << shift) - 1);
+            u32 midpoint = 1u << (shift - 1);
+
+            if (rest > midpoint || (rest == midpoint && (half & 1))) half++;
+
+            return static_cast<u16>(sign | half);
+        }
+
+        // round to nearest even, a carry out of the mantissa correctly bumps the exponent
+        u32 half = (static_cast<u32>(exponent) << 10) | (mantissa >> 13);
+        u32 rest = mantissa & 0x1FFF;
+
+        if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) half++;
+
+        return static_cast<u16>(sign | half);
+    }
+
+    inline auto half_to_float(u16 value) -> f32
+    {
+        u32 sign = static_cast<u32>(value & 0x8000) << 16;
+        u32 exponent = (value >> 10) & 0x1F;
+        u32 mantissa = value & 0x3FF;
+
+        if (exponent == 0) {
+            f32 magnitude = std::ldexp(static_cast<f32>(mantissa), -24);
+            return sign ? -magnitude : magnitude;
+        }
+
+        if (exponent == 31) {
+            return std::bit_cast<f32>(sign | 0x7F800000 | (mantissa << 13));
+        }
+
+        return std::bit_cast<f32>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+    }
+
+    inline auto float_to_snorm16(f32 value) -> i16
+    {
+        return static_cast<i16>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    inline auto snorm16_to_float(i16 value) -> f32
+    {
+        return std::max(static_cast<f32>(value) / 32767.0f, -1.0f);
+    }
+
+    // octahedral mapping of a unit vector onto [-1, 1]^2
+    inline auto encode_octahedral(glm::vec3 normal) -> glm::vec2
+    {
+        f32 norm = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+        if (norm == 0.0f) {
+            return glm::vec2(0.0f);
+        }
+
+        glm::vec2 p = glm::vec2(normal.x, normal.y) / norm;
+
+        if (normal.z < 0.0f) {
+            p = glm::vec2(
+                (1.0f - std::abs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f),
+                (1.0f - std::abs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f)
+            );
+        }
+
+        return p;
+    }
+
+    inline auto decode_octahedral(glm::vec2 p) -> glm::vec3
+    {
+        glm::vec3 normal(p.x, p.y, 1.0f - std::abs(p.x) - std::abs(p.y));
+
+        f32 t = std::max(-normal.z, 0.0f);
+        normal.x += (normal.x >= 0.0f) ? -t : t;
+        normal.y += (normal.y >= 0.0f) ? -t : t;
+
+        return glm::normalize(normal);
+    }
+
+}
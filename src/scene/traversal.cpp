@@ -0,0 +1,228 @@
+#include "traversal.hpp"
+
+#if defined(RTX_SIMD_X86) && defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+// baseline kernels build with the target defaults, sse2 on x86-64 and neon on arm64
+#include "traversal_kernels.inl"
+
+template auto TraversalKernels::intersect_packets<SimdLevel::Baseline>(const BvhNode*, const BvhTriangle*, const u32*, const Ray*, Hit*, usize) -> void;
+template auto TraversalKernels::intersect_stream<SimdLevel::Baseline>(const WideBvhNode*, const BvhTriangle*, const u32*, const Ray*, Hit*, usize) -> void;
+template auto TraversalKernels::intersect_compressed<SimdLevel::Baseline, 4>(const CompressedBvhNode<4>*, const BvhTriangle*, const u32*, const Ray*, Hit*, usize) -> void;
+template auto TraversalKernels::intersect_compressed<SimdLevel::Baseline, 8>(const CompressedBvhNode<8>*, const BvhTriangle*, const u32*, const Ray*, Hit*, usize) -> void;
+
+#if defined(RTX_SIMD_X86)
+
+// instantiated in traversal_avx2.cpp and traversal_avx512.cpp with their instruction sets, never here
+
+extern template auto TraversalKernels::intersect_packets<SimdLevel::Avx2>(const BvhNode*, const BvhTriangle*, const u32*, const Ray*, Hit*, usize) -> void;
+extern template auto TraversalKernels::intersect_stream<SimdLevel::Avx2>(const WideBvhNode*, const BvhTriangle*, const u32*, const Ray*, Hit*, usize) -> void;
+extern template auto TraversalKernels::intersect_compressed<SimdLevel::Avx2, 4>(const CompressedBvhNode<4>*, const BvhTriangle*, const u32*, const Ray*, Hit*, usize) -> void;
+extern template auto TraversalKernels::intersect_compressed<SimdLevel::Avx2, 8>(const CompressedBvhNode<8>*, const BvhTriangle*, const u32*, const Ray*, Hit*, usize) -> void;
+
+extern template auto TraversalKernels::intersect_packets<SimdLevel::Avx512>(const BvhNode*, const BvhTriangle*, const u32*, const Ray*, Hit*, usize) -> void;
+extern template auto TraversalKernels::intersect_stream<SimdLevel::Avx512>(const WideBvhNode*, const BvhTriangle*, const u32*, const Ray*, Hit*, usize) -> void;
+extern template auto TraversalKernels::intersect_compressed<SimdLevel::Avx512, 4>(const CompressedBvhNode<4>*, const BvhTriangle*, const u32*, const Ray*, Hit*, usize) -> void;
+extern template auto TraversalKernels::intersect_compressed<SimdLevel::Avx512, 8>(const CompressedBvhNode<8>*, const BvhTriangle*, const u32*, const Ray*, Hit*, usize) -> void;
+
+#endif
+
+namespace {
+
+    using PacketKernel = auto (*)(const BvhNode*, const BvhTriangle*, const u32*, const Ray*, Hit*, usize) -> void;
+    using StreamKernel = auto (*)(const WideBvhNode*, const BvhTriangle*, const u32*, const Ray*, Hit*, usize) -> void;
+
+    template <u32 Width>
+    using CompressedKernel = auto (*)(const CompressedBvhNode<Width>*, const BvhTriangle*, const u32*, const Ray*, Hit*, usize) -> void;
+
+    struct Kernels
+    {
+        PacketKernel intersect_packets;
+        StreamKernel intersect_stream;
+        CompressedKernel<4> intersect_compressed4;
+        CompressedKernel<8> intersect_compressed8;
+
+        template <u32 Width>
+        auto intersect_compressed() const -> CompressedKernel<Width>
+        {
+            if constexpr (Width == 4) return intersect_compressed4;
+            else return intersect_compressed8;
+        }
+    };
+
+    template <SimdLevel Level>
+    auto kernels_of() -> Kernels
+    {
+        using namespace TraversalKernels;
+
+        return Kernels { intersect_packets<Level>, intersect_stream<Level>, intersect_compressed<Level, 4>, intersect_compressed<Level, 8> };
+    }
+
+    auto kernels(SimdLevel level) -> Kernels
+    {
+        switch (level) {
+#if defined(RTX_SIMD_X86)
+            case SimdLevel::Avx2: return kernels_of<SimdLevel::Avx2>();
+            case SimdLevel::Avx512: return kernels_of<SimdLevel::Avx512>();
+#endif
+            default: return kernels_of<SimdLevel::Baseline>();
+        }
+    }
+
+#if defined(RTX_SIMD_X86)
+
+    struct CpuFeatures
+    {
+        bool avx2 { false };
+        bool avx512 { false };
+    };
+
+    // cpuid leaf 7 ebx: f, dq, cd, bw and vl. msvc's /arch:AVX512 may emit any of them, so all are required
+    constexpr u32 s_avx512_bits = (1u << 16) | (1u << 17) | (1u << 28) | (1u << 30) | (1u << 31);
+
+    // cpu and os support, the os has to save the wider registers on a context switch
+    auto query_cpu_features() -> CpuFeatures
+    {
+        CpuFeatures features;
+
+    #if defined(_MSC_VER)
+        std::array<i32, 4> info;
+
+        __cpuid(info.data(), 0);
+        if (info[0] < 7) return features;
+
+        __cpuid(info.data(), 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (!osxsave) return features;
+
+        u64 xcr0 = _xgetbv(0);
+
+        __cpuidex(info.data(), 7, 0);
+        features.avx2 = (info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+        features.avx512 = (static_cast<u32>(info[1]) & s_avx512_bits) == s_avx512_bits && (xcr0 & 0xe6) == 0xe6;
+    #else
+        __builtin_cpu_init();
+        features.avx2 = __builtin_cpu_supports("avx2");
+        features.avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512cd")
+            && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl");
+    #endif
+
+        return features;
+    }
+
+    auto cpu_supports(SimdLevel level) -> bool
+    {
+        static const CpuFeatures features = query_cpu_features();
+
+        switch (level) {
+            case SimdLevel::Baseline: return true;
+            case SimdLevel::Avx2: return features.avx2;
+            case SimdLevel::Avx512: return features.avx512;
+        }
+
+        return false;
+    }
+
+#else
+
+    auto cpu_supports(SimdLevel level) -> bool
+    {
+        return level == SimdLevel::Baseline;
+    }
+
+#endif
+
+}
+
+auto Traversal::detect() -> SimdLevel
+{
+    static const SimdLevel level = [] {
+        for (SimdLevel candidate : { SimdLevel::Avx512, SimdLevel::Avx2 }) {
+            if (supported(candidate)) return candidate;
+        }
+        return SimdLevel::Baseline;
+    }();
+
+    return level;
+}
+
+auto Traversal::supported(SimdLevel level) -> bool
+{
+    return cpu_supports(level);
+}
+
+auto Traversal::name(SimdLevel level) -> std::string_view
+{
+    switch (level) {
+        case SimdLevel::Baseline: return "baseline";
+        case SimdLevel::Avx2: return "avx2";
+        case SimdLevel::Avx512: return "avx512";
+    }
+
+    return "unknown";
+}
+
+auto Traversal::packet_width(SimdLevel level) -> u32
+{
+    switch (level) {
+        case SimdLevel::Baseline: return TraversalKernels::s_packet_width<SimdLevel::Baseline>;
+        case SimdLevel::Avx2: return TraversalKernels::s_packet_width<SimdLevel::Avx2>;
+        case SimdLevel::Avx512: return TraversalKernels::s_packet_width<SimdLevel::Avx512>;
+    }
+
+    return TraversalKernels::s_packet_width<SimdLevel::Baseline>;
+}
+
+auto Traversal::intersect_packets(const Bvh& bvh, std::span<const Ray> rays, std::span<Hit> hits) -> void
+{
+    intersect_packets(bvh, rays, hits, detect());
+}
+
+auto Traversal::intersect_packets(const Bvh& bvh, std::span<const Ray> rays, std::span<Hit> hits, SimdLevel level) -> void
+{
+    assert(hits.size() >= rays.size());
+    if (bvh.nodes().empty() || rays.empty()) return;
+
+    // unsupported levels fall back instead of faulting on an illegal instruction
+    if (!supported(level)) level = detect();
+
+    kernels(level).intersect_packets(bvh.nodes().data(), bvh.triangles().data(), bvh.primitives().data(), rays.data(), hits.data(), rays.size());
+}
+
+auto Traversal::intersect_stream(const WideBvh& bvh, std::span<const Ray> rays, std::span<Hit> hits) -> void
+{
+    intersect_stream(bvh, rays, hits, detect());
+}
+
+auto Traversal::intersect_stream(const WideBvh& bvh, std::span<const Ray> rays, std::span<Hit> hits, SimdLevel level) -> void
+{
+    assert(hits.size() >= rays.size());
+    if (bvh.nodes().empty() || rays.empty()) return;
+
+    if (!supported(level)) level = detect();
+
+    kernels(level).intersect_stream(bvh.nodes().data(), bvh.triangles().data(), bvh.primitives().data(), rays.data(), hits.data(), rays.size());
+}
+
+template <u32 Width>
+auto Traversal::intersect_stream(const CompressedBvh<Width>& bvh, std::span<const Ray> rays, std::span<Hit> hits) -> void
+{
+    intersect_stream(bvh, rays, hits, detect());
+}
+
+template <u32 Width>
+auto Traversal::intersect_stream(const CompressedBvh<Width>& bvh, std::span<const Ray> rays, std::span<Hit> hits, SimdLevel level) -> void
+{
+    assert(hits.size() >= rays.size());
+    if (bvh.nodes().empty() || rays.empty()) return;
+
+    if (!supported(level)) level = detect();
+
+    kernels(level).template intersect_compressed<Width>()(bvh.nodes().data(), bvh.triangles().data(), bvh.primitives().data(), rays.data(), hits.data(), rays.size());
+}
+
+template auto Traversal::intersect_stream<4>(const CompressedBvh<4>&, std::span<const Ray>, std::span<Hit>) -> void;
+template auto Traversal::intersect_stream<8>(const CompressedBvh<8>&, std::span<const Ray>, std::span<Hit>) -> void;
+template auto Traversal::intersect_stream<4>(const CompressedBvh<4>&, std::span<const Ray>, std::span<Hit>, SimdLevel) -> void;
+template auto Traversal::intersect_stream<8>(const CompressedBvh<8>&, std::span<const Ray>, std::span<Hit>, SimdLevel) -> void;
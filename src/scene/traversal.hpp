@@ -0,0 +1,43 @@
+#pragma once
+
+#include "bvh.hpp"
+#include "wide_bvh.hpp"
+#include "compressed_bvh.hpp"
+
+// instruction sets the traversal kernels are compiled for, each level widens the ray packets
+enum class SimdLevel : u32
+{
+    Baseline,
+    Avx2,
+    Avx512
+};
+
+// vectorized host ray queries. the kernels are built once per simd level and picked at runtime
+class Traversal
+{
+public:
+    // highest level compiled in that this cpu can run
+    static auto detect() -> SimdLevel;
+    static auto supported(SimdLevel level) -> bool;
+
+    static auto name(SimdLevel level) -> std::string_view;
+    // rays per packet, 4, 8 or 16
+    static auto packet_width(SimdLevel level) -> u32;
+
+    // hits are read and written: a ray only records a hit closer than the one already in its slot,
+    // so several meshes can be traced into the same hits one after another
+
+    // coherent rays, consecutive rays are traced together as one packet
+    static auto intersect_packets(const Bvh& bvh, std::span<const Ray> rays, std::span<Hit> hits) -> void;
+    static auto intersect_packets(const Bvh& bvh, std::span<const Ray> rays, std::span<Hit> hits, SimdLevel level) -> void;
+
+    // incoherent rays, one at a time against all 8 children of a wide node
+    static auto intersect_stream(const WideBvh& bvh, std::span<const Ray> rays, std::span<Hit> hits) -> void;
+    static auto intersect_stream(const WideBvh& bvh, std::span<const Ray> rays, std::span<Hit> hits, SimdLevel level) -> void;
+
+    // same as above against quantized child bounds, instantiated for 4 and 8 wide nodes
+    template <u32 Width>
+    static auto intersect_stream(const CompressedBvh<Width>& bvh, std::span<const Ray> rays, std::span<Hit> hits) -> void;
+    template <u32 Width>
+    static auto intersect_stream(const CompressedBvh<Width>& bvh, std::span<const Ray> rays, std::span<Hit> hits, SimdLevel level) -> void;
+};
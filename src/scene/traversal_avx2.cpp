@@ -0,0 +1,11 @@
+// compiled with avx2 enabled, see CMakeLists.txt
+#include "pch.hpp"
+
+#include "traversal.hpp"
+
+#include "traversal_kernels.inl"
+
+template auto TraversalKernels::intersect_packets<SimdLevel::Avx2>(const BvhNode*, const BvhTriangle*, const u32*, const Ray*, Hit*, usize) -> void;
+template auto TraversalKernels::intersect_stream<SimdLevel::Avx2>(const WideBvhNode*, const BvhTriangle*, const u32*, const Ray*, Hit*, usize) -> void;
+template auto TraversalKernels::intersect_compressed<SimdLevel::Avx2, 4>(const CompressedBvhNode<4>*, const BvhTriangle*, const u32*, const Ray*, Hit*, usize) -> void;
+template auto TraversalKernels::intersect_compressed<SimdLevel::Avx2, 8>(const CompressedBvhNode<8>*, const BvhTriangle*, const u32*, const Ray*, Hit*, usize) -> void;
@@ -0,0 +1,11 @@
+// compiled with avx-512 enabled, see CMakeLists.txt
+#include "pch.hpp"
+
+#include "traversal.hpp"
+
+#include "traversal_kernels.inl"
+
+template auto TraversalKernels::intersect_packets<SimdLevel::Avx512>(const BvhNode*, const BvhTriangle*, const u32*, const Ray*, Hit*, usize) -> void;
+template auto TraversalKernels::intersect_stream<SimdLevel::Avx512>(const WideBvhNode*, const BvhTriangle*, const u32*, const Ray*, Hit*, usize) -> void;
+template auto TraversalKernels::intersect_compressed<SimdLevel::Avx512, 4>(const CompressedBvhNode<4>*, const BvhTriangle*, const u32*, const Ray*, Hit*, usize) -> void;
+template auto TraversalKernels::intersect_compressed<SimdLevel::Avx512, 8>(const CompressedBvhNode<8>*, const BvhTriangle*, const u32*, const Ray*, Hit*, usize) -> void;
@@ -0,0 +1,456 @@
+// traversal kernels shared by every simd level. each level's translation unit compiles this file with its own
+// instruction set flags and explicitly instantiates the entry points at the bottom for that level, traversal.cpp
+// declares the others extern. helpers live in an anonymous namespace and use plain arithmetic only, so the linker
+// never folds an avx copy of an inline function into the baseline path
+
+namespace TraversalKernels {
+
+    namespace {
+
+        // builds stop at Bvh::s_MaxDepth and collapsing into wide nodes never adds levels, so a binary traversal keeps
+        // at most one and a wide one at most W - 1 siblings pending per level
+        constexpr u32 s_stack_size = Bvh::s_StackSize;
+
+        template <u32 W>
+        constexpr u32 s_wide_stack_size = (W - 1) * Bvh::s_MaxDepth + 1;
+
+        // oversized leaves hang up to s_SplitDepth extra levels below the deepest node
+        template <u32 W>
+        constexpr u32 s_compressed_stack_size = (W - 1) * (Bvh::s_MaxDepth + CompressedBvh<W>::s_SplitDepth) + 1;
+
+        constexpr f32 s_miss = std::numeric_limits<f32>::max();
+        constexpr u32 s_invalid = std::numeric_limits<u32>::max();
+
+        inline auto min(f32 a, f32 b) -> f32 { return a < b ? a : b; }
+        inline auto max(f32 a, f32 b) -> f32 { return a > b ? a : b; }
+
+        // one ray per lane, hit state is carried in tmax, u, v and primitive
+        template <u32 Width>
+        struct Packet
+        {
+            alignas(64) f32 origin_x[Width];
+            alignas(64) f32 origin_y[Width];
+            alignas(64) f32 origin_z[Width];
+
+            alignas(64) f32 direction_x[Width];
+            alignas(64) f32 direction_y[Width];
+            alignas(64) f32 direction_z[Width];
+
+            alignas(64) f32 inv_x[Width];
+            alignas(64) f32 inv_y[Width];
+            alignas(64) f32 inv_z[Width];
+
+            alignas(64) f32 tmin[Width];
+            alignas(64) f32 tmax[Width];
+
+            alignas(64) f32 u[Width];
+            alignas(64) f32 v[Width];
+            alignas(64) u32 primitive[Width];
+        };
+
+        // true when any lane enters the box before its current closest hit
+        template <u32 Width>
+        inline auto intersect_bounds(const Packet<Width>& packet, const Bounds& bounds) -> bool
+        {
+            f32 min_x = bounds.min.x, min_y = bounds.min.y, min_z = bounds.min.z;
+            f32 max_x = bounds.max.x, max_y = bounds.max.y, max_z = bounds.max.z;
+
+            u32 any = 0;
+            for (u32 i = 0; i < Width; ++i) {
+                f32 x0 = (min_x - packet.origin_x[i]) * packet.inv_x[i];
+                f32 x1 = (max_x - packet.origin_x[i]) * packet.inv_x[i];
+                f32 y0 = (min_y - packet.origin_y[i]) * packet.inv_y[i];
+                f32 y1 = (max_y - packet.origin_y[i]) * packet.inv_y[i];
+                f32 z0 = (min_z - packet.origin_z[i]) * packet.inv_z[i];
+                f32 z1 = (max_z - packet.origin_z[i]) * packet.inv_z[i];
+
+                f32 enter = max(max(min(x0, x1), min(y0, y1)), max(min(z0, z1), packet.tmin[i]));
+                f32 exit = min(min(max(x0, x1), max(y0, y1)), min(max(z0, z1), packet.tmax[i]));
+
+                any |= enter <= exit ? 1u : 0u;
+            }
+
+            return any != 0;
+        }
+
+        // Moller-Trumbore with the triangle broadcast across lanes, same arithmetic as Bvh::intersect
+        template <u32 Width>
+        inline auto intersect_triangle(Packet<Width>& packet, const BvhTriangle& triangle, u32 primitive) -> void
+        {
+            f32 v0_x = triangle.v0.x, v0_y = triangle.v0.y, v0_z = triangle.v0.z;
+
+            f32 e1_x = triangle.v1.x - v0_x, e1_y = triangle.v1.y - v0_y, e1_z = triangle.v1.z - v0_z;
+            f32 e2_x = triangle.v2.x - v0_x, e2_y = triangle.v2.y - v0_y, e2_z = triangle.v2.z - v0_z;
+
+            for (u32 i = 0; i < Width; ++i) {
+                f32 d_x = packet.direction_x[i], d_y = packet.direction_y[i], d_z = packet.direction_z[i];
+
+                f32 p_x = d_y * e2_z - e2_y * d_z;
+                f32 p_y = d_z * e2_x - e2_z * d_x;
+                f32 p_z = d_x * e2_y - e2_x * d_y;
+
+                f32 det = (e1_x * p_x + e1_y * p_y) + e1_z * p_z;
+                f32 inv_det = 1.0f / det;
+
+                f32 s_x = packet.origin_x[i] - v0_x;
+                f32 s_y = packet.origin_y[i] - v0_y;
+                f32 s_z = packet.origin_z[i] - v0_z;
+
+                f32 u = ((s_x * p_x + s_y * p_y) + s_z * p_z) * inv_det;
+
+                f32 q_x = s_y * e1_z - e1_y * s_z;
+                f32 q_y = s_z * e1_x - e1_z * s_x;
+                f32 q_z = s_x * e1_y - e1_x * s_y;
+
+                f32 v = ((d_x * q_x + d_y * q_y) + d_z * q_z) * inv_det;
+                f32 t = ((e2_x * q_x + e2_y * q_y) + e2_z * q_z) * inv_det;
+
+                // bitwise ands keep the loop free of branches so it vectorizes
+                f32 abs_det = det < 0.0f ? -det : det;
+                bool hit = (abs_det >= 1e-12f)
+                    & (u >= 0.0f) & (u <= 1.0f)
+                    & (v >= 0.0f) & (u + v <= 1.0f)
+                    & (t > packet.tmin[i]) & (t < packet.tmax[i]);
+
+                packet.tmax[i] = hit ? t : packet.tmax[i];
+                packet.u[i] = hit ? u : packet.u[i];
+                packet.v[i] = hit ? v : packet.v[i];
+                packet.primitive[i] = hit ? primitive : packet.primitive[i];
+            }
+        }
+
+        template <u32 Width>
+        auto traverse_packet(const BvhNode* nodes, const BvhTriangle* triangles, const u32* primitives, Packet<Width>& packet) -> void
+        {
+            u32 stack[s_stack_size];
+            u32 stack_size = 0;
+
+            stack[stack_size++] = 0;
+
+            while (stack_size > 0) {
+                const BvhNode& node = nodes[stack[--stack_size]];
+
+                // retested on pop so boxes behind the hits found since the push are skipped
+                if (!intersect_bounds(packet, node.bounds)) continue;
+
+                if (node.count > 0) {
+                    for (u32 i = node.first; i < node.first + node.count; ++i) {
+                        intersect_triangle(packet, triangles[i], primitives[i]);
+                    }
+                    continue;
+                }
+
+                // order the children along the first ray, the packet is assumed to be coherent
+                const Bounds& left = nodes[node.first].bounds;
+                const Bounds& right = nodes[node.first + 1].bounds;
+
+                f32 along = (left.min.x + left.max.x - right.min.x - right.max.x) * packet.direction_x[0]
+                    + (left.min.y + left.max.y - right.min.y - right.max.y) * packet.direction_y[0]
+                    + (left.min.z + left.max.z - right.min.z - right.max.z) * packet.direction_z[0];
+
+                if (along > 0.0f) {
+                    stack[stack_size++] = node.first;
+                    stack[stack_size++] = node.first + 1;
+                } else {
+                    stack[stack_size++] = node.first + 1;
+                    stack[stack_size++] = node.first;
+                }
+            }
+        }
+
+        struct StackEntry
+        {
+            u32 child;
+            u32 count;
+            f32 enter;
+        };
+
+        struct SingleRay
+        {
+            f32 origin_x, origin_y, origin_z;
+            f32 direction_x, direction_y, direction_z;
+            f32 inv_x, inv_y, inv_z;
+
+            // the octant picks the near and far planes up front, so boxes need no min/max swap
+            bool negative_x, negative_y, negative_z;
+
+            f32 tmin, tmax;
+        };
+
+        inline auto setup_ray(const Ray& ray, const Hit& hit) -> SingleRay
+        {
+            SingleRay single;
+
+            single.origin_x = ray.origin.x;
+            single.origin_y = ray.origin.y;
+            single.origin_z = ray.origin.z;
+
+            single.direction_x = ray.direction.x;
+            single.direction_y = ray.direction.y;
+            single.direction_z = ray.direction.z;
+
+            single.inv_x = 1.0f / ray.direction.x;
+            single.inv_y = 1.0f / ray.direction.y;
+            single.inv_z = 1.0f / ray.direction.z;
+
+            single.negative_x = single.inv_x < 0.0f;
+            single.negative_y = single.inv_y < 0.0f;
+            single.negative_z = single.inv_z < 0.0f;
+
+            single.tmin = ray.tmin;
+            single.tmax = min(ray.tmax, hit.t);
+
+            return single;
+        }
+
+        inline auto intersect_leaf(SingleRay& ray, const BvhTriangle* triangles, const u32* primitives, u32 first, u32 count, Hit& hit) -> void
+        {
+            for (u32 i = first; i < first + count; ++i) {
+                const BvhTriangle& triangle = triangles[i];
+
+                f32 e1_x = triangle.v1.x - triangle.v0.x, e1_y = triangle.v1.y - triangle.v0.y, e1_z = triangle.v1.z - triangle.v0.z;
+                f32 e2_x = triangle.v2.x - triangle.v0.x, e2_y = triangle.v2.y - triangle.v0.y, e2_z = triangle.v2.z - triangle.v0.z;
+
+                f32 p_x = ray.direction_y * e2_z - e2_y * ray.direction_z;
+                f32 p_y = ray.direction_z * e2_x - e2_z * ray.direction_x;
+                f32 p_z = ray.direction_x * e2_y - e2_x * ray.direction_y;
+
+                f32 det = (e1_x * p_x + e1_y * p_y) + e1_z * p_z;
+                if ((det < 0.0f ? -det : det) < 1e-12f) continue;
+
+                f32 inv_det = 1.0f / det;
+
+                f32 s_x = ray.origin_x - triangle.v0.x, s_y = ray.origin_y - triangle.v0.y, s_z = ray.origin_z - triangle.v0.z;
+
+                f32 u = ((s_x * p_x + s_y * p_y) + s_z * p_z) * inv_det;
+                if (u < 0.0f || u > 1.0f) continue;
+
+                f32 q_x = s_y * e1_z - e1_y * s_z;
+                f32 q_y = s_z * e1_x - e1_z * s_x;
+                f32 q_z = s_x * e1_y - e1_x * s_y;
+
+                f32 v = ((ray.direction_x * q_x + ray.direction_y * q_y) + ray.direction_z * q_z) * inv_det;
+                if (v < 0.0f || u + v > 1.0f) continue;
+
+                f32 t = ((e2_x * q_x + e2_y * q_y) + e2_z * q_z) * inv_det;
+                if (t > ray.tmin && t < ray.tmax) {
+                    ray.tmax = t;
+                    hit.t = t;
+                    hit.u = u;
+                    hit.v = v;
+                    hit.primitive = primitives[i];
+                }
+            }
+        }
+
+        // pushes the children that were hit far to near so the closest one is popped first
+        template <u32 W>
+        inline auto push_sorted(const f32 (&enter)[W], const u32 (&child)[W], const u32 (&count)[W], StackEntry* stack, u32& stack_size) -> void
+        {
+            u32 order[W];
+            u32 hit_count = 0;
+
+            for (u32 c = 0; c < W; ++c) {
+                if (enter[c] == s_miss) continue;
+
+                u32 slot = hit_count++;
+                while (slot > 0 && enter[order[slot - 1]] < enter[c]) {
+                    order[slot] = order[slot - 1];
+                    --slot;
+                }
+                order[slot] = c;
+            }
+
+            for (u32 k = 0; k < hit_count; ++k) {
+                u32 c = order[k];
+                stack[stack_size++] = StackEntry { .child = child[c], .count = count[c], .enter = enter[c] };
+            }
+        }
+
+        auto traverse_wide(const WideBvhNode* nodes, const BvhTriangle* triangles, const u32* primitives, const Ray& input, Hit& hit) -> void
+        {
+            SingleRay ray = setup_ray(input, hit);
+
+            StackEntry stack[s_wide_stack_size<WideBvhNode::s_Width>];
+            u32 stack_size = 0;
+
+            stack[stack_size++] = StackEntry { .child = 0, .count = 0, .enter = ray.tmin };
+
+            while (stack_size > 0) {
+                StackEntry entry = stack[--stack_size];
+                if (entry.enter > ray.tmax) continue;
+
+                if (entry.count > 0) {
+                    intersect_leaf(ray, triangles, primitives, entry.child, entry.count, hit);
+                    continue;
+                }
+
+                const WideBvhNode& node = nodes[entry.child];
+
+                // inverted empty slots fail the slab test on their own
+                const f32* near_x = ray.negative_x ? node.max_x : node.min_x;
+                const f32* near_y = ray.negative_y ? node.max_y : node.min_y;
+                const f32* near_z = ray.negative_z ? node.max_z : node.min_z;
+                const f32* far_x = ray.negative_x ? node.min_x : node.max_x;
+                const f32* far_y = ray.negative_y ? node.min_y : node.max_y;
+                const f32* far_z = ray.negative_z ? node.min_z : node.max_z;
+
+                // all eight slab tests in one pass
+                alignas(32) f32 enter[WideBvhNode::s_Width];
+                for (u32 c = 0; c < WideBvhNode::s_Width; ++c) {
+                    f32 t0 = max(max((near_x[c] - ray.origin_x) * ray.inv_x, (near_y[c] - ray.origin_y) * ray.inv_y), max((near_z[c] - ray.origin_z) * ray.inv_z, ray.tmin));
+                    f32 t1 = min(min((far_x[c] - ray.origin_x) * ray.inv_x, (far_y[c] - ray.origin_y) * ray.inv_y), min((far_z[c] - ray.origin_z) * ray.inv_z, ray.tmax));
+                    enter[c] = t0 <= t1 ? t0 : s_miss;
+                }
+
+                push_sorted(enter, node.child, node.count, stack, stack_size);
+            }
+        }
+
+        template <u32 W>
+        auto traverse_compressed(const CompressedBvhNode<W>* nodes, const BvhTriangle* triangles, const u32* primitives, const Ray& input, Hit& hit) -> void
+        {
+            using Node = CompressedBvhNode<W>;
+
+            SingleRay ray = setup_ray(input, hit);
+
+            StackEntry stack[s_compressed_stack_size<W>];
+            u32 stack_size = 0;
+
+            stack[stack_size++] = StackEntry { .child = 0, .count = 0, .enter = ray.tmin };
+
+            while (stack_size > 0) {
+                StackEntry entry = stack[--stack_size];
+                if (entry.enter > ray.tmax) continue;
+
+                if (entry.count > 0) {
+                    intersect_leaf(ray, triangles, primitives, entry.child, entry.count, hit);
+                    continue;
+                }
+
+                const Node& node = nodes[entry.child];
+
+                // 2^exponent assembled from its bits, the exponent is stored with the ieee bias
+                f32 scale[3];
+                for (u32 axis = 0; axis < 3; ++axis) {
+                    u32 bits = static_cast<u32>(node.exponent[axis]) << 23;
+                    std::memcpy(&scale[axis], &bits, sizeof(f32));
+                }
+
+                const u8* near_x = ray.negative_x ? node.max_x : node.min_x;
+                const u8* near_y = ray.negative_y ? node.max_y : node.min_y;
+                const u8* near_z = ray.negative_z ? node.max_z : node.min_z;
+                const u8* far_x = ray.negative_x ? node.min_x : node.max_x;
+                const u8* far_y = ray.negative_y ? node.min_y : node.max_y;
+                const u8* far_z = ray.negative_z ? node.min_z : node.max_z;
+
+                // dequantized exactly like the builder rounded them, origin + q * scale
+                alignas(32) f32 enter[W];
+                for (u32 c = 0; c < W; ++c) {
+                    f32 near_tx = (node.origin[0] + static_cast<f32>(near_x[c]) * scale[0] - ray.origin_x) * ray.inv_x;
+                    f32 near_ty = (node.origin[1] + static_cast<f32>(near_y[c]) * scale[1] - ray.origin_y) * ray.inv_y;
+                    f32 near_tz = (node.origin[2] + static_cast<f32>(near_z[c]) * scale[2] - ray.origin_z) * ray.inv_z;
+                    f32 far_tx = (node.origin[0] + static_cast<f32>(far_x[c]) * scale[0] - ray.origin_x) * ray.inv_x;
+                    f32 far_ty = (node.origin[1] + static_cast<f32>(far_y[c]) * scale[1] - ray.origin_y) * ray.inv_y;
+                    f32 far_tz = (node.origin[2] + static_cast<f32>(far_z[c]) * scale[2] - ray.origin_z) * ray.inv_z;
+
+                    f32 t0 = max(max(near_tx, near_ty), max(near_tz, ray.tmin));
+                    f32 t1 = min(min(far_tx, far_ty), min(far_tz, ray.tmax));
+                    enter[c] = (t0 <= t1) & (node.meta[c] != Node::s_Empty) ? t0 : s_miss;
+                }
+
+                // child references follow from the slot order, inner nodes and leaf ranges are packed
+                u32 child[W];
+                u32 count[W];
+
+                u32 next_node = node.first_node;
+                u32 next_triangle = node.first_triangle;
+                for (u32 c = 0; c < W; ++c) {
+                    bool inner = node.meta[c] == Node::s_Inner;
+                    child[c] = inner ? next_node : next_triangle;
+                    count[c] = inner ? 0 : node.meta[c];
+
+                    next_node += inner ? 1 : 0;
+                    next_triangle += count[c];
+                }
+
+                push_sorted(enter, child, count, stack, stack_size);
+            }
+        }
+
+        // the packet kernel, Width rays traced together per packet
+        template <u32 Width>
+        auto trace_packets(const BvhNode* nodes, const BvhTriangle* triangles, const u32* primitives, const Ray* rays, Hit* hits, usize count) -> void
+        {
+            for (usize first = 0; first < count; first += Width) {
+                usize active = count - first < Width ? count - first : Width;
+
+                Packet<Width> packet;
+                for (u32 i = 0; i < Width; ++i) {
+                    // padding lanes repeat the first ray with an empty interval
+                    bool padding = i >= active;
+                    const Ray& ray = rays[padding ? first : first + i];
+
+                    packet.origin_x[i] = ray.origin.x;
+                    packet.origin_y[i] = ray.origin.y;
+                    packet.origin_z[i] = ray.origin.z;
+
+                    packet.direction_x[i] = ray.direction.x;
+                    packet.direction_y[i] = ray.direction.y;
+                    packet.direction_z[i] = ray.direction.z;
+
+                    packet.inv_x[i] = 1.0f / ray.direction.x;
+                    packet.inv_y[i] = 1.0f / ray.direction.y;
+                    packet.inv_z[i] = 1.0f / ray.direction.z;
+
+                    packet.tmin[i] = padding ? 1.0f : ray.tmin;
+                    packet.tmax[i] = padding ? 0.0f : min(ray.tmax, hits[first + i].t);
+
+                    packet.u[i] = 0.0f;
+                    packet.v[i] = 0.0f;
+                    packet.primitive[i] = s_invalid;
+                }
+
+                traverse_packet(nodes, triangles, primitives, packet);
+
+                for (u32 i = 0; i < active; ++i) {
+                    if (packet.primitive[i] == s_invalid) continue;
+
+                    Hit& hit = hits[first + i];
+                    hit.t = packet.tmax[i];
+                    hit.u = packet.u[i];
+                    hit.v = packet.v[i];
+                    hit.primitive = packet.primitive[i];
+                }
+            }
+        }
+
+    }
+
+    // rays per packet at each level, one f32 lane per register element
+    template <SimdLevel Level>
+    constexpr u32 s_packet_width = (Level == SimdLevel::Avx512) ? 16 : (Level == SimdLevel::Avx2) ? 8 : 4;
+
+    template <SimdLevel Level>
+    auto intersect_packets(const BvhNode* nodes, const BvhTriangle* triangles, const u32* primitives, const Ray* rays, Hit* hits, usize count) -> void
+    {
+        trace_packets<s_packet_width<Level>>(nodes, triangles, primitives, rays, hits, count);
+    }
+
+    template <SimdLevel Level>
+    auto intersect_stream(const WideBvhNode* nodes, const BvhTriangle* triangles, const u32* primitives, const Ray* rays, Hit* hits, usize count) -> void
+    {
+        for (usize i = 0; i < count; ++i) {
+            traverse_wide(nodes, triangles, primitives, rays[i], hits[i]);
+        }
+    }
+
+    template <SimdLevel Level, u32 Width>
+    auto intersect_compressed(const CompressedBvhNode<Width>* nodes, const BvhTriangle* triangles, const u32* primitives, const Ray* rays, Hit* hits, usize count) -> void
+    {
+        for (usize i = 0; i < count; ++i) {
+            traverse_compressed(nodes, triangles, primitives, rays[i], hits[i]);
+        }
+    }
+
+}
@@ -0,0 +1,149 @@
+#include "wavefront.hpp"
+
+namespace {
+
+    constexpr u32 s_morton_bits = 9;
+    constexpr u32 s_radix_bits = 11;
+
+    // spreads the low 10 bits of v to every third bit
+    auto spread_bits(u32 v) -> u32
+    {
+        v &= 0x000003ff;
+        v = (v | (v << 16)) & 0x030000ff;
+        v = (v | (v << 8)) & 0x0300f00f;
+        v = (v | (v << 4)) & 0x030c30c3;
+        v = (v | (v << 2)) & 0x09249249;
+        return v;
+    }
+
+    // lsd radix sort on the upper 32 bits, the lower half carries the payload along
+    auto radix_sort(std::vector<u64>& items) -> void
+    {
+        constexpr u32 bucket_count = 1u << s_radix_bits;
+
+        std::vector<u64> temp(items.size());
+
+        for (u32 shift = 32; shift < 64; shift += s_radix_bits) {
+            std::array<u32, bucket_count> offsets {};
+            for (u64 item : items) {
+                offsets[(item >> shift) & (bucket_count - 1)]++;
+            }
+
+            // every key agrees on this digit, nothing to move
+            if (std::ranges::find(offsets, static_cast<u32>(items.size())) != offsets.end()) continue;
+
+            u32 sum = 0;
+            for (auto& offset : offsets) {
+                u32 count = offset;
+                offset = sum;
+                sum += count;
+            }
+
+            for (u64 item : items) {
+                temp[offsets[(item >> shift) & (bucket_count - 1)]++] = item;
+            }
+
+            items.swap(temp);
+        }
+    }
+
+}
+
+Wavefront::Wavefront(const Bounds& scene, const WavefrontOptions& options)
+    : m_scene(scene), m_options(options)
+{
+    m_options.batch_size = std::max(m_options.batch_size, 1u);
+}
+
+auto Wavefront::push(const Ray& ray, u32 id) -> void
+{
+    m_rays.push_back(ray);
+    m_ids.push_back(id);
+}
+
+auto Wavefront::trace(const WideBvh& bvh, std::span<Hit> hits) -> void
+{
+    trace(bvh, hits, Traversal::detect());
+}
+
+auto Wavefront::trace(const WideBvh& bvh, std::span<Hit> hits, SimdLevel level) -> void
+{
+    if (m_rays.empty()) return;
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<u32> order;
+    if (m_options.sort) {
+        std::vector<u32> keys(m_rays.size());
+        for (usize i = 0; i < m_rays.size(); ++i) {
+            keys[i] = sort_key(m_rays[i], m_scene);
+        }
+        order = sort(keys);
+    } else {
+        order.resize(m_rays.size());
+        std::iota(order.begin(), order.end(), 0u);
+    }
+
+    auto sorted = std::chrono::steady_clock::now();
+
+    for (usize first = 0; first < order.size(); first += m_options.batch_size) {
+        usize count = std::min<usize>(m_options.batch_size, order.size() - first);
+
+        // gathered so the kernels read rays and hits sequentially
+        m_batch_rays.resize(count);
+        m_batch_hits.resize(count);
+        for (usize i = 0; i < count; ++i) {
+            u32 ray = order[first + i];
+            m_batch_rays[i] = m_rays[ray];
+            m_batch_hits[i] = hits[m_ids[ray]];
+        }
+
+        Traversal::intersect_stream(bvh, m_batch_rays, m_batch_hits, level);
+
+        for (usize i = 0; i < count; ++i) {
+            hits[m_ids[order[first + i]]] = m_batch_hits[i];
+        }
+
+        m_stats.batches++;
+    }
+
+    auto traced = std::chrono::steady_clock::now();
+
+    m_stats.rays += m_rays.size();
+    m_stats.sort_ms += std::chrono::duration<f64, std::milli>(sorted - start).count();
+    m_stats.trace_ms += std::chrono::duration<f64, std::milli>(traced - sorted).count();
+
+    m_rays.clear();
+    m_ids.clear();
+}
+
+auto Wavefront::sort_key(const Ray& ray, const Bounds& scene) -> u32
+{
+    u32 octant = (ray.direction.x < 0.0f ? 1u : 0u) | (ray.direction.y < 0.0f ? 2u : 0u) | (ray.direction.z < 0.0f ? 4u : 0u);
+
+    constexpr f32 cells = static_cast<f32>((1u << s_morton_bits) - 1);
+
+    glm::vec3 extent = glm::max(scene.max - scene.min, glm::vec3(std::numeric_limits<f32>::min()));
+    glm::vec3 cell = glm::clamp((ray.origin - scene.min) / extent, 0.0f, 1.0f) * cells;
+
+    u32 morton = spread_bits(static_cast<u32>(cell.x)) | (spread_bits(static_cast<u32>(cell.y)) << 1) | (spread_bits(static_cast<u32>(cell.z)) << 2);
+
+    return (octant << (3 * s_morton_bits)) | morton;
+}
+
+auto Wavefront::sort(std::span<const u32> keys) -> std::vector<u32>
+{
+    std::vector<u64> items(keys.size());
+    for (usize i = 0; i < keys.size(); ++i) {
+        items[i] = (static_cast<u64>(keys[i]) << 32) | static_cast<u64>(i);
+    }
+
+    radix_sort(items);
+
+    std::vector<u32> order(items.size());
+    for (usize i = 0; i < items.size(); ++i) {
+        order[i] = static_cast<u32>(items[i]);
+    }
+
+    return order;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "traversal.hpp"
+
+struct WavefrontOptions
+{
+    // rays handed to the traversal kernels per call, the sorted queue is cut into batches of this size
+    u32 batch_size { 1 << 14 };
+    // reorder by direction octant and origin morton code before tracing
+    bool sort { true };
+};
+
+struct WavefrontStats
+{
+    usize rays { 0 };
+    usize batches { 0 };
+    f64 sort_ms { 0.0 };
+    f64 trace_ms { 0.0 };
+};
+
+// buffers rays, typically the next bounce of every pixel, and traces them together once the queue is full. sorting
+// the queue groups rays that start close together and head the same way, so consecutive rays walk the same nodes and
+// the BVH stays in cache instead of being streamed in again for every incoherent ray
+class Wavefront
+{
+public:
+    Wavefront(const Bounds& scene, const WavefrontOptions& options = {});
+
+    // id is the hit slot the result goes to, usually the pixel
+    auto push(const Ray& ray, u32 id) -> void;
+
+    [[nodiscard]] auto size() const -> usize { return m_rays.size(); }
+    [[nodiscard]] auto empty() const -> bool { return m_rays.empty(); }
+
+    // traces and empties the queue. hits[id] is only replaced by a closer hit, as in Traversal
+    auto trace(const WideBvh& bvh, std::span<Hit> hits) -> void;
+    auto trace(const WideBvh& bvh, std::span<Hit> hits, SimdLevel level) -> void;
+
+    // accumulated over every trace since construction or the last reset
+    [[nodiscard]] auto stats() const -> const WavefrontStats& { return m_stats; }
+    auto reset_stats() -> void { m_stats = {}; }
+
+    // direction octant in bits 27-29, 9 bit per axis morton code of the origin within the scene below
+    static auto sort_key(const Ray& ray, const Bounds& scene) -> u32;
+    // permutation that orders the keys ascending, equal keys keep their order
+    static auto sort(std::span<const u32> keys) -> std::vector<u32>;
+
+private:
+    Bounds m_scene;
+    WavefrontOptions m_options;
+    WavefrontStats m_stats;
+
+    std::vector<Ray> m_rays;
+    std::vector<u32> m_ids;
+
+    // reused between traces
+    std::vector<Ray> m_batch_rays;
+    std::vector<Hit> m_batch_hits;
+};
@@ -0,0 +1,98 @@
+#include "wide_bvh.hpp"
+
+namespace {
+
+    struct Collapser
+    {
+        std::span<const BvhNode> nodes;
+        std::vector<WideBvhNode>& wide;
+
+        // pulls up to 8 descendants of a binary node into one wide node, returns its index
+        auto collapse(u32 source) -> u32
+        {
+            std::array<u32, WideBvhNode::s_Width> children;
+            u32 count = 0;
+
+            const auto& root = nodes[source];
+            if (root.leaf()) {
+                children[count++] = source;
+            } else {
+                children[count++] = root.first;
+                children[count++] = root.first + 1;
+            }
+
+            // open the largest inner child until the node is full, large boxes are the ones most rays enter
+            while (count < WideBvhNode::s_Width) {
+                i32 best = -1;
+                f32 best_area = -1.0f;
+
+                for (u32 c = 0; c < count; ++c) {
+                    const auto& child = nodes[children[c]];
+                    if (!child.leaf() && child.bounds.surface_area() > best_area) {
+                        best = static_cast<i32>(c);
+                        best_area = child.bounds.surface_area();
+                    }
+                }
+
+                if (best < 0) break;
+
+                u32 opened = children[best];
+                children[best] = nodes[opened].first;
+                children[count++] = nodes[opened].first + 1;
+            }
+
+            u32 index = static_cast<u32>(wide.size());
+
+            WideBvhNode node;
+            for (u32 c = 0; c < WideBvhNode::s_Width; ++c) {
+                Bounds bounds = c < count ? nodes[children[c]].bounds : Bounds {};
+
+                node.min_x[c] = bounds.min.x;
+                node.min_y[c] = bounds.min.y;
+                node.min_z[c] = bounds.min.z;
+                node.max_x[c] = bounds.max.x;
+                node.max_y[c] = bounds.max.y;
+                node.max_z[c] = bounds.max.z;
+
+                node.child[c] = WideBvhNode::s_Empty;
+                node.count[c] = 0;
+            }
+            wide.push_back(node);
+
+            // children are collapsed after the push, recursion grows the vector
+            for (u32 c = 0; c < count; ++c) {
+                const auto& child = nodes[children[c]];
+                if (child.leaf()) {
+                    wide[index].child[c] = child.first;
+                    wide[index].count[c] = child.count;
+                } else {
+                    u32 collapsed = collapse(children[c]);
+                    wide[index].child[c] = collapsed;
+                }
+            }
+
+            return index;
+        }
+    };
+
+}
+
+auto WideBvh::build(const Bvh& bvh) -> WideBvh
+{
+    WideBvh wide;
+
+    if (bvh.nodes().empty()) {
+        return wide;
+    }
+
+    // every wide node absorbs at least one binary inner node
+    wide.m_nodes.reserve(bvh.nodes().size() / 2 + 1);
+
+    Collapser collapser { .nodes = bvh.nodes(), .wide = wide.m_nodes };
+    collapser.collapse(0);
+
+    wide.m_primitives.assign(bvh.primitives().begin(), bvh.primitives().end());
+    wide.m_triangles.assign(bvh.triangles().begin(), bvh.triangles().end());
+
+    return wide;
+}
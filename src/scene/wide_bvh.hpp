@@ -0,0 +1,42 @@
+#pragma once
+
+#include "bvh.hpp"
+
+// eight children in structure of arrays form so a single ray tests all of them in one pass.
+// plain arrays keep the simd kernels free of inline helpers that differ per instruction set
+struct alignas(32) WideBvhNode
+{
+    inline static constexpr u32 s_Width { 8 };
+    inline static constexpr u32 s_Empty { std::numeric_limits<u32>::max() };
+
+    // empty slots hold inverted bounds and never pass the slab test
+    f32 min_x[s_Width];
+    f32 min_y[s_Width];
+    f32 min_z[s_Width];
+    f32 max_x[s_Width];
+    f32 max_y[s_Width];
+    f32 max_z[s_Width];
+
+    // inner children: node index, leaves: first triangle, empty slots: s_Empty
+    u32 child[s_Width];
+    // triangles in a leaf child, 0 for inner children and empty slots
+    u32 count[s_Width];
+};
+
+// binary BVH collapsed into 8 wide nodes for single ray traversal of incoherent rays
+class WideBvh
+{
+public:
+    // keeps the leaves and triangle order of the source tree
+    static auto build(const Bvh& bvh) -> WideBvh;
+
+    [[nodiscard]] auto nodes() const -> std::span<const WideBvhNode> { return m_nodes; }
+    [[nodiscard]] auto primitives() const -> std::span<const u32> { return m_primitives; }
+    [[nodiscard]] auto triangles() const -> std::span<const BvhTriangle> { return m_triangles; }
+
+private:
+    std::vector<WideBvhNode> m_nodes;
+
+    std::vector<u32> m_primitives;
+    std::vector<BvhTriangle> m_triangles;
+};